@@ -0,0 +1,205 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include "quicksort.h"
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+class perf_counters {
+public:
+    static constexpr std::size_t count = 6;
+    static constexpr std::array<const char*, count> names = {"cycles", "instr", "br-miss", "L1d-miss", "LLC-miss", "dTLB-miss"};
+
+    perf_counters() {
+#if defined(__linux__)
+        constexpr auto cache = [](std::uint64_t id) {
+            return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        const std::array<std::pair<std::uint32_t, std::uint64_t>, count> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D)},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL)},
+            {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB)},
+        }};
+        for (std::size_t i = 0; i < count; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    bool available() const {
+        return std::any_of(fds_.begin(), fds_.end(), [](int fd) { return fd >= 0; });
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (int fd : fds_) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    std::array<double, count> stop() {
+        std::array<double, count> values;
+        values.fill(-1);
+#if defined(__linux__)
+        for (std::size_t i = 0; i < count; ++i) {
+            if (fds_[i] < 0) continue;
+            ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t raw[3];
+            if (read(fds_[i], raw, sizeof(raw)) != static_cast<ssize_t>(sizeof(raw)) || raw[2] == 0) continue;
+            values[i] = static_cast<double>(raw[0]) * static_cast<double>(raw[1]) / static_cast<double>(raw[2]);
+        }
+#endif
+        return values;
+    }
+
+private:
+    std::array<int, count> fds_ = {-1, -1, -1, -1, -1, -1};
+};
+
+struct measurement {
+    double ns = 0;
+    std::array<double, perf_counters::count> counters{};
+};
+
+struct record {
+    std::uint64_t key;
+    std::array<std::uint64_t, 7> payload;
+};
+
+template <class T, class Sort>
+measurement measure(perf_counters& perf, const std::vector<T>& input, Sort sort, int repeats) {
+    measurement best;
+    auto n = static_cast<double>(input.size());
+    for (int r = 0; r < repeats; ++r) {
+        std::vector<T> data = input;
+        perf.start();
+        auto start = std::chrono::steady_clock::now();
+        sort(data);
+        auto stop = std::chrono::steady_clock::now();
+        auto counters = perf.stop();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count() / n;
+        if (r == 0 || ns < best.ns) {
+            best.ns = ns;
+            for (std::size_t i = 0; i < counters.size(); ++i) {
+                best.counters[i] = counters[i] < 0 ? -1 : counters[i] / n;
+            }
+        }
+    }
+    return best;
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(12) << "config" << std::setw(11) << "impl" << std::right << std::setw(10) << "n"
+              << std::setw(10) << "ns";
+    for (const char* name : perf_counters::names) {
+        std::cout << std::setw(11) << name;
+    }
+    std::cout << '\n';
+}
+
+void print_row(const std::string& config, const std::string& impl, std::size_t n, const measurement& m) {
+    std::cout << std::left << std::setw(12) << config << std::setw(11) << impl << std::right << std::setw(10) << n
+              << std::fixed << std::setprecision(2) << std::setw(10) << m.ns;
+    for (double value : m.counters) {
+        if (value < 0) {
+            std::cout << std::setw(11) << "-";
+        } else {
+            std::cout << std::setw(11) << value;
+        }
+    }
+    std::cout << '\n';
+}
+
+template <class T, class Quicksort, class Baseline>
+void run(perf_counters& perf, const std::string& name, const std::vector<T>& input, Quicksort quicksort, Baseline baseline, int repeats) {
+    print_row(name, "quicksort", input.size(), measure(perf, input, quicksort, repeats));
+    print_row(name, "std::sort", input.size(), measure(perf, input, baseline, repeats));
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t(1) << 22;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+    std::mt19937_64 gen(42);
+    perf_counters perf;
+
+    std::cout << "prefetch distance " << QUICKSORT_PREFETCH_DISTANCE << " bytes, per element";
+    if (!perf.available()) std::cout << " (hardware counters unavailable)";
+    std::cout << '\n';
+    print_header();
+
+    std::vector<std::int64_t> ints(n);
+    for (auto& i : ints) {
+        i = static_cast<std::int64_t>(gen());
+    }
+    run(perf, "int64", ints,
+        [](auto& v) { quicksort::sort(v.begin(), v.end(), std::greater<>()); },
+        [](auto& v) { std::sort(v.begin(), v.end(), std::greater<>()); }, repeats);
+
+    auto by_key = [](const record& a, const record& b) { return a.key < b.key; };
+    std::vector<record> records(n / 4);
+    for (auto& r : records) {
+        r.key = gen();
+        r.payload.fill(r.key);
+    }
+    run(perf, "record64", records,
+        [&](auto& v) { quicksort::sort(v.begin(), v.end(), by_key); },
+        [&](auto& v) { std::sort(v.begin(), v.end(), by_key); }, repeats);
+
+    auto by_pointee = [](const record* a, const record* b) { return a->key < b->key; };
+    std::vector<const record*> pointers(records.size());
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        pointers[i] = &records[i];
+    }
+    run(perf, "pointer", pointers,
+        [&](auto& v) { quicksort::sort(v.begin(), v.end(), by_pointee); },
+        [&](auto& v) { std::sort(v.begin(), v.end(), by_pointee); }, repeats);
+
+    std::vector<std::uint8_t> unused(records.size());
+    run(perf, "argsort", unused,
+        [&](auto&) { quicksort::argsort(records.begin(), records.end(), by_key); },
+        [&](auto&) {
+            std::vector<std::size_t> perm(records.size());
+            std::iota(perm.begin(), perm.end(), std::size_t(0));
+            std::sort(perm.begin(), perm.end(), [&](std::size_t a, std::size_t b) { return by_key(records[a], records[b]); });
+        }, repeats);
+
+    return 0;
+}
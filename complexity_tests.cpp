@@ -0,0 +1,204 @@
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <gtest/gtest.h>
+
+#ifdef USE_CONCEPTS
+    #include "quicksort.h"
+#else
+    #include "quicksort_SFINAE.h"
+#endif
+
+struct operation_counts {
+    std::size_t comparisons = 0;
+    std::size_t moves = 0;
+};
+
+struct counted {
+    static inline operation_counts* sink = nullptr;
+
+    int value = 0;
+
+    counted() = default;
+    counted(int v) : value(v) {}
+    counted(const counted& other) : value(other.value) { ++sink->moves; }
+    counted(counted&& other) noexcept : value(other.value) { ++sink->moves; }
+    counted& operator=(const counted& other) {
+        ++sink->moves;
+        value = other.value;
+        return *this;
+    }
+    counted& operator=(counted&& other) noexcept {
+        ++sink->moves;
+        value = other.value;
+        return *this;
+    }
+};
+
+struct counting_less {
+    operation_counts* counts;
+
+    bool operator()(int a, int b) const {
+        ++counts->comparisons;
+        return a < b;
+    }
+
+    bool operator()(const counted& a, const counted& b) const {
+        ++counts->comparisons;
+        return a.value < b.value;
+    }
+};
+
+struct distribution {
+    std::string name;
+    std::vector<int> (*generate)(std::size_t n);
+    double comparison_budget;
+    double move_budget;
+};
+
+void PrintTo(const distribution& d, std::ostream* os) {
+    *os << d.name;
+}
+
+std::vector<int> random_values(std::size_t n) {
+    std::mt19937 gen(static_cast<unsigned>(n));
+    std::vector<int> v(n);
+    for (int& x : v) {
+        x = static_cast<int>(gen() >> 1);
+    }
+    return v;
+}
+
+std::vector<int> few_unique(std::size_t n) {
+    std::mt19937 gen(static_cast<unsigned>(n));
+    std::vector<int> v(n);
+    for (int& x : v) {
+        x = static_cast<int>(gen() % 4);
+    }
+    return v;
+}
+
+std::vector<int> zero_one(std::size_t n) {
+    std::mt19937 gen(static_cast<unsigned>(n));
+    std::vector<int> v(n);
+    for (int& x : v) {
+        x = static_cast<int>(gen() % 2);
+    }
+    return v;
+}
+
+std::vector<int> ascending(std::size_t n) {
+    std::vector<int> v(n);
+    std::iota(v.begin(), v.end(), 0);
+    return v;
+}
+
+std::vector<int> descending(std::size_t n) {
+    std::vector<int> v = ascending(n);
+    std::reverse(v.begin(), v.end());
+    return v;
+}
+
+std::vector<int> all_equal(std::size_t n) {
+    return std::vector<int>(n, 7);
+}
+
+std::vector<int> organ_pipe(std::size_t n) {
+    std::vector<int> v(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = static_cast<int>(std::min(i, n - i));
+    }
+    return v;
+}
+
+std::vector<int> sawtooth(std::size_t n) {
+    std::vector<int> v(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = static_cast<int>(i % 1024);
+    }
+    return v;
+}
+
+std::vector<int> sorted_with_tail(std::size_t n) {
+    std::vector<int> v = ascending(n);
+    std::mt19937 gen(static_cast<unsigned>(n));
+    for (std::size_t i = n - n / 100; i < n; ++i) {
+        v[i] = static_cast<int>(gen() % n);
+    }
+    return v;
+}
+
+std::vector<int> median_of_three_killer(std::size_t n) {
+    std::size_t k = n / 2;
+    std::vector<int> v(n);
+    for (std::size_t i = 1; i <= k; ++i) {
+        if (i % 2) {
+            v[i - 1] = static_cast<int>(i);
+            v[i] = static_cast<int>(k + i);
+        }
+        v[k + i - 1] = static_cast<int>(2 * i);
+    }
+    return v;
+}
+
+std::vector<int> interleaved(std::size_t n) {
+    std::vector<int> v(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = static_cast<int>(i % 2 ? n - i : i);
+    }
+    return v;
+}
+
+class QuicksortComplexityTest : public ::testing::TestWithParam<distribution> {};
+
+TEST_P(QuicksortComplexityTest, WithinBudget) {
+    const distribution& d = GetParam();
+    for (std::size_t n : {1000u, 10000u, 100000u, 1000000u}) {
+        SCOPED_TRACE("n = " + std::to_string(n));
+        double n_log_n = static_cast<double>(n) * std::log2(static_cast<double>(n));
+        std::vector<int> input = d.generate(n);
+        std::vector<int> expected = input;
+        std::sort(expected.begin(), expected.end());
+
+        operation_counts int_counts;
+        std::vector<int> ints = input;
+        quicksort::sort(ints.begin(), ints.end(), counting_less{&int_counts});
+        EXPECT_EQ(ints, expected);
+        EXPECT_LE(static_cast<double>(int_counts.comparisons), d.comparison_budget * n_log_n);
+
+        operation_counts counts;
+        counted::sink = &counts;
+        std::vector<counted> values(input.begin(), input.end());
+        counts = {};
+        quicksort::sort(values.begin(), values.end(), counting_less{&counts});
+        EXPECT_TRUE(std::equal(values.begin(), values.end(), expected.begin(),
+                               [](const counted& a, int b) { return a.value == b; }));
+        EXPECT_LE(static_cast<double>(counts.comparisons), d.comparison_budget * n_log_n);
+        EXPECT_LE(static_cast<double>(counts.moves), d.move_budget * n_log_n);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Distributions, QuicksortComplexityTest, ::testing::Values(
+    distribution{"random", random_values, 2.0, 1.5},
+    distribution{"few_unique", few_unique, 1.0, 0.5},
+    distribution{"zero_one", zero_one, 1.0, 0.5},
+    distribution{"ascending", ascending, 0.25, 0.1},
+    distribution{"descending", descending, 0.25, 0.5},
+    distribution{"all_equal", all_equal, 0.25, 0.1},
+    distribution{"organ_pipe", organ_pipe, 4.0, 2.0},
+    distribution{"sawtooth", sawtooth, 1.0, 1.5},
+    distribution{"sorted_with_tail", sorted_with_tail, 0.5, 0.5},
+    distribution{"median_of_three_killer", median_of_three_killer, 4.5, 2.5},
+    distribution{"interleaved", interleaved, 3.5, 1.0}),
+    [](const ::testing::TestParamInfo<distribution>& param) { return param.param.name; });
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,53 @@
 #include <type_traits>
 #include <iterator>
 #include <concepts>
+#include <memory>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <forward_list>
+#include <tuple>
+#include <bit>
+#include <numeric>
+#include <new>
+#include <cerrno>
+#include <system_error>
+#include <thread>
+#include <mutex>
+#include <barrier>
+#include <atomic>
+#include <random>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <coroutine>
+#include <chrono>
+#include <exception>
+#include <memory_resource>
+#include <initializer_list>
+
+#define QUICKSORT_INSTANTIATION_TYPES(X) \
+    X(char) X(unsigned char) X(short) X(unsigned short) X(int) X(unsigned int) X(long) X(float) X(double)
+
+#ifndef QUICKSORT_PREFETCH_DISTANCE
+    #define QUICKSORT_PREFETCH_DISTANCE 512
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 namespace quicksort {
     template <class It>
@@ -14,34 +61,2300 @@ namespace quicksort {
         ++i; *i; i - j;
         std::iter_swap(i,j);
     };
+    namespace prefetch_impl {
+        constexpr std::size_t threshold_bytes = std::size_t(1) << 22;
+        constexpr std::size_t distance_bytes = QUICKSORT_PREFETCH_DISTANCE;
+
+        inline void _read(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p, 0, 3);
+#else
+            (void)p;
+#endif
+        }
+
+        template <class Compare, class T, class = void>
+        struct has_key_address : std::false_type {};
+
+        template <class Compare, class T>
+        struct has_key_address<Compare, T, std::void_t<decltype(std::declval<const Compare&>().key_address(std::declval<const T&>()))>>
+            : std::true_type {};
+
+        struct none {
+            template <class It>
+            constexpr void ahead(It) const noexcept {}
+            template <class It>
+            constexpr void behind(It) const noexcept {}
+        };
+
+        template <class T, class Compare>
+        struct scanner {
+            static constexpr std::ptrdiff_t distance = std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(distance_bytes / sizeof(T)));
+
+            T* first;
+            T* last;
+            const Compare& comp;
+
+            void ahead(T* p) const noexcept {
+                if (last - p > distance) _touch(p + distance);
+            }
+
+            void behind(T* p) const noexcept {
+                if (p - first >= distance) _touch(p - distance);
+            }
+
+            void _touch(const T* p) const noexcept {
+                _read(p);
+                if constexpr (has_key_address<Compare, T>::value) {
+                    _read(comp.key_address(*p));
+                } else if constexpr (std::is_pointer_v<T>) {
+                    _read(*p);
+                }
+            }
+        };
+    }
+
     namespace random_access_impl {
+        template <class It, class Compare, class Prefetch>
+        constexpr It _hole_partition(It first, It last, Compare& comp, const Prefetch& prefetch) {
+            typename std::iterator_traits<It>::value_type pivot = std::ranges::iter_move(last - 1);
+            It lo = first;
+            It hi = last - 1;
+            while (true) {
+                while (lo != hi && comp(*lo, pivot)) prefetch.ahead(++lo);
+                if (lo == hi) break;
+                *hi = std::ranges::iter_move(lo);
+                --hi;
+                while (lo != hi && !comp(*hi, pivot)) prefetch.behind(--hi);
+                if (lo == hi) break;
+                *lo = std::ranges::iter_move(hi);
+                ++lo;
+            }
+            *lo = std::move(pivot);
+            return lo;
+        }
+
+        template <class It, class Compare, class Prefetch>
+        constexpr It _partition(It first, It last, Compare& comp, const Prefetch& prefetch) {
+            using std::iter_swap;
+            using value_type = typename std::iterator_traits<It>::value_type;
+            if constexpr (std::is_trivially_copyable_v<value_type>) {
+                It pivot_it = last - 1;
+                const auto& pivot = *pivot_it;
+                It i = first;
+                for (It j = first; j != pivot_it; ++j) {
+                    prefetch.ahead(j);
+                    if (comp(*j, pivot)) {
+                        iter_swap(i, j);
+                        ++i;
+                    }
+                }
+                iter_swap(i, pivot_it);
+                return i;
+            } else {
+                return _hole_partition(first, last, comp, prefetch);
+            }
+        }
+
         template <class It, class Compare>
-        void _sort(It first, It last, Compare comp) {
+        constexpr It _partition(It first, It last, Compare& comp) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            if constexpr (std::is_pointer_v<It> && prefetch_impl::distance_bytes > 0) {
+                if (!std::is_constant_evaluated()
+                    && static_cast<std::size_t>(last - first) * sizeof(value_type) >= prefetch_impl::threshold_bytes) {
+                    return _partition(first, last, comp, prefetch_impl::scanner<value_type, Compare>{first, last, comp});
+                }
+            }
+            return _partition(first, last, comp, prefetch_impl::none{});
+        }
+
+        constexpr std::ptrdiff_t insertion_threshold = 16;
+
+        template <class It, class Compare>
+        constexpr void _insertion_sort(It first, It last, Compare& comp) {
+            if (first == last) return;
+            for (It i = first + 1; i != last; ++i) {
+                if (!comp(*i, *(i - 1))) continue;
+                typename std::iterator_traits<It>::value_type tmp = std::ranges::iter_move(i);
+                It j = i;
+                do {
+                    *j = std::ranges::iter_move(j - 1);
+                    --j;
+                } while (j != first && comp(tmp, *(j - 1)));
+                *j = std::move(tmp);
+            }
+        }
+
+        template <class It, class Compare>
+        constexpr void _median_to_back(It first, It last, Compare& comp) {
+            using std::iter_swap;
+            It a = first;
+            It b = first + (last - first) / 2;
+            It c = last - 1;
+            if (comp(*b, *a)) iter_swap(a, b);
+            if (comp(*c, *b)) {
+                iter_swap(b, c);
+                if (comp(*b, *a)) iter_swap(a, b);
+            }
+            iter_swap(b, c);
+        }
+
+        template <class It, class Compare>
+        constexpr void _introsort(It first, It last, Compare& comp, int depth, bool leftmost) {
+            while (last - first > insertion_threshold) {
+                if (depth-- == 0) {
+                    std::make_heap(first, last, comp);
+                    std::sort_heap(first, last, comp);
+                    return;
+                }
+
+                _median_to_back(first, last, comp);
+                if (!leftmost && !comp(*(first - 1), *(last - 1))) {
+                    auto not_after = [&comp](const auto& a, const auto& b) { return !comp(b, a); };
+                    first = _partition(first, last, not_after) + 1;
+                    continue;
+                }
+
+                It mid = _partition(first, last, comp);
+                if (mid - first < last - mid) {
+                    _introsort(first, mid, comp, depth, leftmost);
+                    first = mid + 1;
+                    leftmost = false;
+                } else {
+                    _introsort(mid + 1, last, comp, depth, false);
+                    last = mid;
+                }
+            }
+            _insertion_sort(first, last, comp);
+        }
+
+        template <class It, class Compare>
+        constexpr void _sort(It first, It last, Compare comp) {
+            auto n = static_cast<std::size_t>(last - first);
+            if (n < 2) return;
+            _introsort(first, last, comp, 2 * static_cast<int>(std::bit_width(n)), true);
+        }
+
+        template <class It, class Compare>
+        constexpr void _select(It first, It nth, It last, Compare& comp) {
+            using std::iter_swap;
+            while (last - first > 2) {
+                It mid = first + (last - first) / 2;
+                if (comp(*mid, *first)) iter_swap(mid, first);
+                if (comp(*(last - 1), *first)) iter_swap(last - 1, first);
+                if (comp(*mid, *(last - 1))) iter_swap(mid, last - 1);
+
+                It pivot = _partition(first, last, comp);
+                if (pivot == nth) return;
+                if (nth < pivot) {
+                    last = pivot;
+                } else {
+                    first = pivot + 1;
+                }
+            }
+            if (last - first == 2 && comp(*(last - 1), *first)) iter_swap(first, last - 1);
+        }
+    }
+    namespace network_impl {
+        constexpr std::size_t max_size = 32;
+
+        template <class Emit>
+        constexpr void _batcher(std::size_t n, Emit emit) {
+            for (std::size_t p = 1; p < n; p *= 2) {
+                for (std::size_t k = p; k >= 1; k /= 2) {
+                    for (std::size_t j = k % p; j + k < n; j += 2 * k) {
+                        for (std::size_t i = 0; i < k && i + j + k < n; ++i) {
+                            if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                                emit(i + j, i + j + k);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        template <std::size_t N>
+        struct network {
+            static constexpr std::size_t size = [] {
+                std::size_t count = 0;
+                _batcher(N, [&](std::size_t, std::size_t) { ++count; });
+                return count;
+            }();
+
+            static constexpr auto pairs = [] {
+                std::array<std::pair<std::size_t, std::size_t>, size> result{};
+                std::size_t count = 0;
+                _batcher(N, [&](std::size_t a, std::size_t b) { result[count++] = {a, b}; });
+                return result;
+            }();
+        };
+
+        template <class T, class Compare>
+        constexpr void _compare_exchange(T& a, T& b, Compare& comp) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                bool swapped = comp(b, a);
+                T lo = swapped ? b : a;
+                T hi = swapped ? a : b;
+                a = lo;
+                b = hi;
+            } else {
+                using std::swap;
+                if (comp(b, a)) swap(a, b);
+            }
+        }
+
+        template <class T, std::size_t N, class Compare, std::size_t... I>
+        constexpr void _sort(std::array<T, N>& arr, Compare& comp, std::index_sequence<I...>) {
+            (_compare_exchange(arr[network<N>::pairs[I].first], arr[network<N>::pairs[I].second], comp), ...);
+        }
+    }
+
+    namespace string_impl {
+        constexpr std::ptrdiff_t insertion_threshold = 16;
+
+        template <class T, class Compare>
+        struct is_default_ordering : std::bool_constant<
+            (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+            && (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<T>>)> {};
+
+        template <class S>
+        int _char_at(const S& s, std::size_t depth) {
+            return depth < s.size() ? static_cast<unsigned char>(s[depth]) : -1;
+        }
+
+        template <class S>
+        bool _less_from(const S& a, const S& b, std::size_t depth) {
+            return std::string_view(a).substr(depth) < std::string_view(b).substr(depth);
+        }
+
+        template <class It>
+        void _insertion_sort(It first, It last, std::size_t depth) {
+            for (It i = first + 1; i < last; ++i) {
+                if (!_less_from(*i, *(i - 1), depth)) continue;
+                auto value = std::move(*i);
+                It hole = i;
+                do {
+                    *hole = std::move(*(hole - 1));
+                    --hole;
+                } while (hole != first && _less_from(value, *(hole - 1), depth));
+                *hole = std::move(value);
+            }
+        }
+
+        template <class It>
+        void _sort(It first, It last, std::size_t depth) {
             using std::iter_swap;
+            while (last - first > insertion_threshold) {
+                int a = _char_at(*first, depth);
+                int b = _char_at(*(first + (last - first) / 2), depth);
+                int c = _char_at(*(last - 1), depth);
+                int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+                It lt = first, i = first, gt = last;
+                while (i < gt) {
+                    int ch = _char_at(*i, depth);
+                    if (ch < pivot) {
+                        iter_swap(lt++, i++);
+                    } else if (ch > pivot) {
+                        iter_swap(i, --gt);
+                    } else {
+                        ++i;
+                    }
+                }
+
+                _sort(first, lt, depth);
+                _sort(gt, last, depth);
+                if (pivot < 0) return;
+                first = lt;
+                last = gt;
+                ++depth;
+            }
+            if (last - first > 1) _insertion_sort(first, last, depth);
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    struct huge_page_options {
+        bool hugetlbfs = false;
+        unsigned prefault_threads = 0;
+        std::size_t min_bytes = std::size_t(1) << 21;
+    };
+
+    class huge_page_resource : public std::pmr::memory_resource {
+    public:
+        static constexpr std::size_t page_size = std::size_t(1) << 21;
+
+        explicit huge_page_resource(huge_page_options opts = {}, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+            : options_(opts), upstream_(upstream) {}
+
+    private:
+        static constexpr std::size_t prefault_chunk = std::size_t(1) << 25;
+
+        bool _mapped(std::size_t bytes, std::size_t alignment) const noexcept {
+            return bytes >= options_.min_bytes && alignment <= page_size;
+        }
+
+        static std::size_t _length(std::size_t bytes) noexcept { return (bytes + page_size - 1) & ~(page_size - 1); }
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (!_mapped(bytes, alignment)) return upstream_->allocate(bytes, alignment);
+            std::size_t length = _length(bytes);
+            void* p = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+            if (options_.hugetlbfs) p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            if (p == MAP_FAILED) p = _map_aligned(length);
+            _prefault(static_cast<std::byte*>(p), length);
+            return p;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            if (!_mapped(bytes, alignment)) {
+                upstream_->deallocate(p, bytes, alignment);
+            } else {
+                munmap(p, _length(bytes));
+            }
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        static void* _map_aligned(std::size_t length) {
+            void* raw = mmap(nullptr, length + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) throw std::bad_alloc();
+            auto begin = reinterpret_cast<std::uintptr_t>(raw);
+            auto aligned = (begin + page_size - 1) & ~(page_size - 1);
+            if (aligned != begin) munmap(raw, aligned - begin);
+            if (aligned + length != begin + length + page_size) {
+                munmap(reinterpret_cast<void*>(aligned + length), begin + page_size - aligned);
+            }
+            auto* p = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+            madvise(p, length, MADV_HUGEPAGE);
+#endif
+            return p;
+        }
+
+        void _prefault(std::byte* p, std::size_t length) const {
+            auto base_page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            auto touch = [p, base_page](std::size_t begin, std::size_t end) {
+                for (std::size_t offset = begin; offset < end; offset += base_page) {
+                    p[offset] = std::byte{0};
+                }
+            };
+
+            unsigned threads = options_.prefault_threads ? options_.prefault_threads : std::max(1u, std::thread::hardware_concurrency());
+            threads = static_cast<unsigned>(std::clamp<std::size_t>(length / prefault_chunk, 1, threads));
+            std::size_t pages = length / page_size;
+            std::vector<std::thread> team;
+            team.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                team.emplace_back(touch, pages * t / threads * page_size, pages * (t + 1) / threads * page_size);
+            }
+            touch(0, pages / threads * page_size);
+            for (std::thread& thread : team) {
+                thread.join();
+            }
+        }
+
+        huge_page_options options_;
+        std::pmr::memory_resource* upstream_;
+    };
+#endif
+
+    class scratch_arena : public std::pmr::memory_resource {
+    public:
+        static constexpr std::size_t block_alignment = 64;
+
+        explicit scratch_arena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+            : upstream_(upstream) {}
+        scratch_arena(const scratch_arena&) = delete;
+        scratch_arena& operator=(const scratch_arena&) = delete;
+        ~scratch_arena() override { _release(); }
+
+        std::size_t capacity() const noexcept { return capacity_; }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            bytes = std::max(bytes, std::size_t(1));
+            if (live_ == 0 && std::max(peak_, bytes + alignment) > capacity_) _grow(std::max(peak_, bytes + alignment));
+            std::size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+            void* p;
+            if (alignment <= block_alignment && start + bytes <= capacity_) {
+                p = block_ + start;
+                offset_ = start + bytes;
+            } else {
+                p = upstream_->allocate(bytes, alignment);
+            }
+            demand_ += bytes + alignment;
+            peak_ = std::max(peak_, demand_);
+            ++live_;
+            return p;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            bytes = std::max(bytes, std::size_t(1));
+            auto address = reinterpret_cast<std::uintptr_t>(p);
+            auto base = reinterpret_cast<std::uintptr_t>(block_);
+            if (!block_ || address < base || address >= base + capacity_) upstream_->deallocate(p, bytes, alignment);
+            demand_ -= bytes + alignment;
+            if (--live_ == 0) offset_ = 0;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        void _grow(std::size_t bytes) {
+            _release();
+            std::size_t capacity = std::bit_ceil(bytes);
+            block_ = static_cast<std::byte*>(upstream_->allocate(capacity, block_alignment));
+            capacity_ = capacity;
+        }
+
+        void _release() noexcept {
+            if (block_) upstream_->deallocate(block_, capacity_, block_alignment);
+            block_ = nullptr;
+            capacity_ = 0;
+        }
+
+        std::pmr::memory_resource* upstream_;
+        std::byte* block_ = nullptr;
+        std::size_t capacity_ = 0;
+        std::size_t offset_ = 0;
+        std::size_t live_ = 0;
+        std::size_t demand_ = 0;
+        std::size_t peak_ = 0;
+    };
+
+    namespace scratch_impl {
+        inline scratch_arena& _thread_arena() {
+#if defined(__unix__) || defined(__APPLE__)
+            thread_local huge_page_resource pages;
+            thread_local scratch_arena arena(&pages);
+#else
+            thread_local scratch_arena arena;
+#endif
+            return arena;
+        }
+
+        inline std::pmr::memory_resource*& _current() {
+            thread_local std::pmr::memory_resource* current = nullptr;
+            return current;
+        }
+    }
+
+    inline std::pmr::memory_resource* scratch_resource() noexcept {
+        std::pmr::memory_resource* current = scratch_impl::_current();
+        return current ? current : &scratch_impl::_thread_arena();
+    }
+
+    class scratch_scope {
+    public:
+        explicit scratch_scope(std::pmr::memory_resource* resource) noexcept
+            : previous_(std::exchange(scratch_impl::_current(), resource)) {}
+        scratch_scope(const scratch_scope&) = delete;
+        scratch_scope& operator=(const scratch_scope&) = delete;
+        ~scratch_scope() { scratch_impl::_current() = previous_; }
+
+    private:
+        std::pmr::memory_resource* previous_;
+    };
+
+    namespace adaptive_impl {
+        constexpr std::ptrdiff_t min_size = 512;
+        constexpr std::ptrdiff_t min_run = 32;
+        constexpr std::ptrdiff_t min_gallop = 7;
+        constexpr int sample_size = 64;
+        constexpr int sample_threshold = 60;
+
+        template <class It, class Compare>
+        bool _looks_presorted(It first, It last, Compare& comp) {
+            auto n = last - first;
+            if (n < min_size) return false;
+            int ascending = 0, descending = 0;
+            for (int s = 0; s < sample_size; ++s) {
+                It it = first + (n - 1) * s / sample_size;
+                if (comp(*(it + 1), *it)) {
+                    ++descending;
+                } else {
+                    ++ascending;
+                }
+            }
+            return ascending >= sample_threshold || descending >= sample_threshold;
+        }
+
+        template <class It, class Pred>
+        It _gallop(It first, It last, Pred pred) {
             auto n = last - first;
+            decltype(n) hi = 1;
+            while (hi < n && pred(first[hi])) hi *= 2;
+            return std::partition_point(first + hi / 2, first + std::min(hi, n), pred);
+        }
+
+        template <class It, class Compare>
+        It _find_run(It first, It last, Compare& comp) {
+            It run_end = first + 1;
+            if (run_end == last) return run_end;
+            if (comp(*run_end, *first)) {
+                while (run_end + 1 != last && comp(*(run_end + 1), *run_end)) ++run_end;
+                std::reverse(first, ++run_end);
+            } else {
+                while (run_end + 1 != last && !comp(*(run_end + 1), *run_end)) ++run_end;
+                ++run_end;
+            }
+            return run_end;
+        }
+
+        template <class It, class Compare>
+        void _extend_run(It first, It run_end, It new_end, Compare& comp) {
+            for (It i = run_end; i != new_end; ++i) {
+                It pos = std::upper_bound(first, i, *i, comp);
+                std::rotate(pos, i, i + 1);
+            }
+        }
+
+        inline unsigned _node_power(std::size_t n, std::size_t begin_a, std::size_t begin_b, std::size_t end_b) {
+            std::size_t l = begin_a + begin_b, r = begin_b + end_b, two_n = 2 * n;
+            unsigned power = 0;
+            while (true) {
+                ++power;
+                l *= 2;
+                r *= 2;
+                bool bit_l = l >= two_n, bit_r = r >= two_n;
+                if (bit_l != bit_r) return power;
+                if (bit_l) {
+                    l -= two_n;
+                    r -= two_n;
+                }
+            }
+        }
+
+        template <class It, class Buffer, class Compare>
+        void _merge(It first, It mid, It last, Buffer& buffer, Compare& comp) {
+            first = _gallop(first, mid, [&](const auto& x) { return !comp(*mid, x); });
+            last = _gallop(std::make_reverse_iterator(last), std::make_reverse_iterator(mid),
+                           [&](const auto& x) { return !comp(x, *(mid - 1)); }).base();
+            if (first == mid || mid == last) return;
+
+            buffer.assign(std::make_move_iterator(first), std::make_move_iterator(mid));
+            auto a = buffer.begin(), a_end = buffer.end();
+            It b = mid, out = first;
+            std::ptrdiff_t a_wins = 0, b_wins = 0;
+            while (a != a_end && b != last) {
+                if (comp(*b, *a)) {
+                    *out++ = std::move(*b++);
+                    ++b_wins;
+                    a_wins = 0;
+                } else {
+                    *out++ = std::move(*a++);
+                    ++a_wins;
+                    b_wins = 0;
+                }
+                if (a_wins >= min_gallop && b != last) {
+                    auto a_next = _gallop(a, a_end, [&](const auto& x) { return !comp(*b, x); });
+                    out = std::move(a, a_next, out);
+                    a = a_next;
+                    a_wins = 0;
+                } else if (b_wins >= min_gallop && a != a_end) {
+                    It b_next = _gallop(b, last, [&](const auto& x) { return comp(x, *a); });
+                    out = std::move(b, b_next, out);
+                    b = b_next;
+                    b_wins = 0;
+                }
+            }
+            std::move(a, a_end, out);
+        }
+
+        template <class It, class Compare>
+        void _sort(It first, It last, Compare comp, std::pmr::memory_resource* resource) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            struct run {
+                It begin;
+                It end;
+                unsigned power;
+            };
+
+            auto n = static_cast<std::size_t>(last - first);
             if (n < 2) return;
+            auto offset = [first](It it) { return static_cast<std::size_t>(it - first); };
 
-            It pivot_it = last - 1;
-            const auto& pivot = *pivot_it;
+            std::pmr::vector<value_type> buffer(resource);
+            buffer.reserve(n / 2 + 1);
+            std::array<run, 2 * sizeof(std::size_t) * 8 + 1> stack;
+            std::size_t top = 0;
 
-            It i = first;
-            for (It j = first; j != pivot_it; ++j) {
-                if (comp(*j, pivot)) {
-                    iter_swap(i, j);
-                    ++i;
+            auto next_run = [&](It begin) {
+                It end = _find_run(begin, last, comp);
+                if (end - begin < min_run && end != last) {
+                    It new_end = begin + std::min(min_run, last - begin);
+                    _extend_run(begin, end, new_end, comp);
+                    end = new_end;
                 }
+                return end;
+            };
+
+            It cur_begin = first;
+            It cur_end = next_run(first);
+            while (cur_end != last) {
+                It next_end = next_run(cur_end);
+                unsigned power = _node_power(n, offset(cur_begin), offset(cur_end), offset(next_end));
+                while (top > 0 && stack[top - 1].power > power) {
+                    --top;
+                    _merge(stack[top].begin, stack[top].end, cur_end, buffer, comp);
+                    cur_begin = stack[top].begin;
+                }
+                stack[top++] = {cur_begin, cur_end, power};
+                cur_begin = cur_end;
+                cur_end = next_end;
             }
-            iter_swap(i, pivot_it);
+            while (top > 0) {
+                --top;
+                _merge(stack[top].begin, stack[top].end, last, buffer, comp);
+            }
+        }
+    }
+
+    namespace random_access_impl {
+        template <class It, class Compare>
+        void _dispatch(It first, It last, Compare comp) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            if (adaptive_impl::_looks_presorted(first, last, comp)) {
+                adaptive_impl::_sort(first, last, comp, scratch_resource());
+            } else if constexpr (string_impl::is_default_ordering<value_type, Compare>::value) {
+                string_impl::_sort(first, last, 0);
+            } else {
+                _sort(first, last, comp);
+            }
+        }
+
+#if defined(QUICKSORT_EXTERN_TEMPLATES)
+    #define QUICKSORT_EXTERN_DISPATCH(T) extern template void _dispatch<T*, std::less<>>(T*, T*, std::less<>);
+        QUICKSORT_INSTANTIATION_TYPES(QUICKSORT_EXTERN_DISPATCH)
+    #undef QUICKSORT_EXTERN_DISPATCH
+#endif
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    constexpr void sort(It first, It last, Compare comp = {}) {
+        if (std::is_constant_evaluated()) {
+            random_access_impl::_sort(first, last, comp);
+        } else if constexpr (std::contiguous_iterator<It>) {
+            auto p = std::to_address(first);
+            random_access_impl::_dispatch(p, p + (last - first), comp);
+        } else {
+            random_access_impl::_dispatch(first, last, comp);
+        }
+    }
+
+    template <class T, std::size_t N, class Compare = std::less<>>
+    constexpr void sort(std::array<T, N>& arr, Compare comp = {}) {
+        if constexpr (N <= network_impl::max_size) {
+            network_impl::_sort(arr, comp, std::make_index_sequence<network_impl::network<N>::size>{});
+        } else {
+            quicksort::sort(arr.begin(), arr.end(), comp);
+        }
+    }
 
-            _sort(first, i, comp);
-            _sort(++i, last, comp);
+    namespace batch_impl {
+        template <class T>
+        struct array_traits : std::false_type {};
+
+        template <class T, std::size_t N>
+        struct array_traits<std::array<T, N>> : std::true_type {
+            using element_type = T;
+            static constexpr std::size_t size = N;
+        };
+
+        template <class T>
+        constexpr std::size_t lane_count = sizeof(T) <= 4 ? 16 : 8;
+
+        template <class T, std::size_t W, class Compare>
+        void _compare_exchange(std::array<T, W>& a, std::array<T, W>& b, Compare& comp) {
+            for (std::size_t w = 0; w < W; ++w) {
+                T x = a[w], y = b[w];
+                bool swapped = comp(y, x);
+                a[w] = swapped ? y : x;
+                b[w] = swapped ? x : y;
+            }
+        }
+
+        template <class T, std::size_t W, std::size_t N, class Compare, std::size_t... I>
+        void _network(std::array<std::array<T, W>, N>& lanes, Compare& comp, std::index_sequence<I...>) {
+            using network = network_impl::network<N>;
+            (_compare_exchange(lanes[network::pairs[I].first], lanes[network::pairs[I].second], comp), ...);
+        }
+
+        template <class It, class Compare>
+        void _sort(It first, It last, Compare comp) {
+            using array_type = typename std::iterator_traits<It>::value_type;
+            using T = typename array_traits<array_type>::element_type;
+            constexpr std::size_t N = array_traits<array_type>::size;
+            constexpr std::size_t W = lane_count<T>;
+
+            if constexpr (N <= network_impl::max_size && std::is_trivially_copyable_v<T>) {
+                std::array<std::array<T, W>, N> lanes;
+                for (; last - first >= static_cast<std::ptrdiff_t>(W); first += static_cast<std::ptrdiff_t>(W)) {
+                    for (std::size_t w = 0; w < W; ++w) {
+                        const array_type& arr = first[static_cast<std::ptrdiff_t>(w)];
+                        for (std::size_t k = 0; k < N; ++k) lanes[k][w] = arr[k];
+                    }
+                    _network(lanes, comp, std::make_index_sequence<network_impl::network<N>::size>{});
+                    for (std::size_t w = 0; w < W; ++w) {
+                        array_type& arr = first[static_cast<std::ptrdiff_t>(w)];
+                        for (std::size_t k = 0; k < N; ++k) arr[k] = lanes[k][w];
+                    }
+                }
+            }
+            for (; first != last; ++first) {
+                quicksort::sort(*first, comp);
+            }
         }
     }
 
     template <random_access_iterator It, class Compare = std::less<>>
+        requires batch_impl::array_traits<typename std::iterator_traits<It>::value_type>::value
+    void batch_sort(It first, It last, Compare comp = {}) {
+        batch_impl::_sort(first, last, comp);
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    void adaptive_sort(It first, It last, Compare comp = {}, std::pmr::memory_resource* resource = scratch_resource()) {
+        adaptive_impl::_sort(first, last, comp, resource);
+    }
+
+    template <std::forward_iterator It, class Compare = std::less<>>
+        requires (!random_access_iterator<It>)
     void sort(It first, It last, Compare comp = {}) {
-        random_access_impl::_sort(first, last, comp);
+        using value_type = typename std::iterator_traits<It>::value_type;
+        std::pmr::vector<value_type> buffer(std::make_move_iterator(first), std::make_move_iterator(last), scratch_resource());
+        quicksort::sort(buffer.begin(), buffer.end(), comp);
+        std::move(buffer.begin(), buffer.end(), first);
+    }
+
+    namespace list_impl {
+        template <class List, class Compare>
+        void _merge(List& list, typename List::iterator first, typename List::iterator mid,
+                    std::size_t len1, std::size_t len2, Compare& comp) {
+            while (len1 > 0 && len2 > 0) {
+                if (comp(*mid, *first)) {
+                    auto next = std::next(mid);
+                    list.splice(first, list, mid);
+                    mid = next;
+                    --len2;
+                } else {
+                    ++first;
+                    --len1;
+                }
+            }
+        }
+
+        template <class List, class Compare>
+        void _sort(List& list, Compare& comp) {
+            std::size_t n = list.size();
+            for (std::size_t width = 1; width < n; width *= 2) {
+                auto first = list.begin();
+                for (std::size_t done = 0; done + width < n; done += 2 * width) {
+                    std::size_t len2 = std::min(width, n - done - width);
+                    auto mid = std::next(first, static_cast<std::ptrdiff_t>(width));
+                    auto last = std::next(mid, static_cast<std::ptrdiff_t>(len2));
+                    _merge(list, first, mid, width, len2, comp);
+                    first = last;
+                }
+            }
+        }
+
+        template <class ForwardList, class Compare>
+        void _sort_forward(ForwardList& list, Compare& comp) {
+            auto n = static_cast<std::size_t>(std::distance(list.begin(), list.end()));
+            for (std::size_t width = 1; width < n; width *= 2) {
+                auto before = list.before_begin();
+                for (std::size_t done = 0; done + width < n; done += 2 * width) {
+                    std::size_t len1 = width;
+                    std::size_t len2 = std::min(width, n - done - width);
+                    auto before_mid = std::next(before, static_cast<std::ptrdiff_t>(width));
+                    auto cursor = before;
+                    while (len1 > 0 && len2 > 0) {
+                        if (comp(*std::next(before_mid), *std::next(cursor))) {
+                            list.splice_after(cursor, list, before_mid);
+                            --len2;
+                        } else {
+                            --len1;
+                        }
+                        ++cursor;
+                    }
+                    before = std::next(before_mid, static_cast<std::ptrdiff_t>(len2));
+                }
+            }
+        }
+    }
+
+    template <class T, class Alloc, class Compare = std::less<>>
+    void sort(std::list<T, Alloc>& list, Compare comp = {}) {
+        list_impl::_sort(list, comp);
+    }
+
+    template <class T, class Alloc, class Compare = std::less<>>
+    void sort(std::forward_list<T, Alloc>& list, Compare comp = {}) {
+        list_impl::_sort_forward(list, comp);
+    }
+
+    namespace prefix_impl {
+        template <class T>
+        struct entry {
+            std::uint64_t prefix;
+            T* element;
+        };
+    }
+
+    inline std::uint64_t string_prefix(std::string_view s) {
+        std::uint64_t prefix = 0;
+        for (std::size_t i = 0; i < sizeof(prefix); ++i) {
+            prefix <<= 8;
+            if (i < s.size()) prefix |= static_cast<unsigned char>(s[i]);
+        }
+        return prefix;
+    }
+
+    template <random_access_iterator It, class Prefix, class Compare = std::less<>>
+        requires std::is_invocable_r_v<std::uint64_t, Prefix&, const typename std::iterator_traits<It>::value_type&>
+    void sort_by_prefix(It first, It last, Prefix prefix, Compare comp = {}, std::pmr::memory_resource* resource = scratch_resource()) {
+        using value_type = typename std::iterator_traits<It>::value_type;
+        using entry = prefix_impl::entry<std::remove_reference_t<decltype(*first)>>;
+        if (last - first < 2) return;
+
+        std::pmr::vector<entry> entries(resource);
+        entries.reserve(static_cast<std::size_t>(last - first));
+        for (It it = first; it != last; ++it) {
+            entries.push_back({static_cast<std::uint64_t>(prefix(std::as_const(*it))), std::addressof(*it)});
+        }
+
+        quicksort::sort(entries.begin(), entries.end(), [&comp](const entry& a, const entry& b) {
+            if (a.prefix != b.prefix) return a.prefix < b.prefix;
+            return static_cast<bool>(comp(*a.element, *b.element));
+        });
+
+        std::pmr::vector<value_type> sorted(resource);
+        sorted.reserve(entries.size());
+        for (const entry& e : entries) {
+            sorted.push_back(std::move(*e.element));
+        }
+        std::move(sorted.begin(), sorted.end(), first);
+    }
+
+    namespace zip_impl {
+        template <class... It>
+        struct reference : std::tuple<typename std::iterator_traits<It>::reference...> {
+            using base = std::tuple<typename std::iterator_traits<It>::reference...>;
+            using base::base;
+
+            reference(const reference&) = default;
+
+            const reference& operator=(const reference& other) const {
+                _assign(other, std::index_sequence_for<It...>{});
+                return *this;
+            }
+
+            template <class Tuple>
+            const reference& operator=(Tuple&& other) const {
+                _assign(std::forward<Tuple>(other), std::index_sequence_for<It...>{});
+                return *this;
+            }
+
+            friend void swap(reference a, reference b) {
+                a._swap(b, std::index_sequence_for<It...>{});
+            }
+
+        private:
+            template <class Tuple, std::size_t... I>
+            void _assign(Tuple&& other, std::index_sequence<I...>) const {
+                ((std::get<I>(static_cast<const base&>(*this)) = std::get<I>(std::forward<Tuple>(other))), ...);
+            }
+
+            template <std::size_t... I>
+            void _swap(reference& other, std::index_sequence<I...>) {
+                using std::swap;
+                (swap(std::get<I>(static_cast<base&>(*this)), std::get<I>(static_cast<base&>(other))), ...);
+            }
+        };
+    }
+
+    template <class... It>
+    class zip_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::tuple<typename std::iterator_traits<It>::value_type...>;
+        using difference_type = std::ptrdiff_t;
+        using reference = zip_impl::reference<It...>;
+        using pointer = void;
+
+        zip_iterator() = default;
+        explicit zip_iterator(It... its) : its_(its...) {}
+
+        reference operator*() const {
+            return std::apply([](const auto&... it) { return reference(*it...); }, its_);
+        }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        zip_iterator& operator+=(difference_type n) {
+            std::apply([n](auto&... it) { ((it += n), ...); }, its_);
+            return *this;
+        }
+        zip_iterator& operator-=(difference_type n) { return *this += -n; }
+        zip_iterator& operator++() { return *this += 1; }
+        zip_iterator& operator--() { return *this -= 1; }
+        zip_iterator operator++(int) { zip_iterator old = *this; ++*this; return old; }
+        zip_iterator operator--(int) { zip_iterator old = *this; --*this; return old; }
+
+        friend zip_iterator operator+(zip_iterator it, difference_type n) { return it += n; }
+        friend zip_iterator operator+(difference_type n, zip_iterator it) { return it += n; }
+        friend zip_iterator operator-(zip_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const zip_iterator& a, const zip_iterator& b) {
+            return static_cast<difference_type>(std::get<0>(a.its_) - std::get<0>(b.its_));
+        }
+
+        friend bool operator==(const zip_iterator& a, const zip_iterator& b) { return std::get<0>(a.its_) == std::get<0>(b.its_); }
+        friend bool operator!=(const zip_iterator& a, const zip_iterator& b) { return !(a == b); }
+        friend bool operator<(const zip_iterator& a, const zip_iterator& b) { return a - b < 0; }
+        friend bool operator>(const zip_iterator& a, const zip_iterator& b) { return b < a; }
+        friend bool operator<=(const zip_iterator& a, const zip_iterator& b) { return !(b < a); }
+        friend bool operator>=(const zip_iterator& a, const zip_iterator& b) { return !(a < b); }
+
+        friend std::tuple<typename std::iterator_traits<It>::value_type&&...> iter_move(const zip_iterator& it) {
+            return std::apply([](const auto&... i) {
+                return std::tuple<typename std::iterator_traits<It>::value_type&&...>(std::move(*i)...);
+            }, it.its_);
+        }
+
+    private:
+        std::tuple<It...> its_;
+    };
+
+    template <class... It>
+    zip_iterator<It...> make_zip_iterator(It... its) {
+        return zip_iterator<It...>(its...);
+    }
+
+    namespace radix_impl {
+        template <class T>
+        struct is_radix_key : std::bool_constant<
+            (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+            || std::is_same_v<T, float> || std::is_same_v<T, double>> {};
+
+        template <class T>
+        auto _ordered_bits(T key) {
+            if constexpr (std::is_floating_point_v<T>) {
+                using bits_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+                auto bits = std::bit_cast<bits_type>(key);
+                constexpr bits_type sign = bits_type(1) << (sizeof(bits_type) * 8 - 1);
+                return static_cast<bits_type>((bits & sign) ? ~bits : bits | sign);
+            } else if constexpr (std::is_signed_v<T>) {
+                using bits_type = std::make_unsigned_t<T>;
+                constexpr bits_type sign = static_cast<bits_type>(bits_type(1) << (sizeof(bits_type) * 8 - 1));
+                return static_cast<bits_type>(static_cast<bits_type>(key) ^ sign);
+            } else {
+                return key;
+            }
+        }
+
+        template <class T, class Compare>
+        struct is_default_ordering : std::bool_constant<is_radix_key<T>::value
+            && (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<T>>)> {};
+
+        template <class Perm = std::vector<std::size_t>>
+        Perm _identity(std::size_t n, typename Perm::allocator_type alloc = {}) {
+            Perm perm(n, alloc);
+            std::iota(perm.begin(), perm.end(), std::size_t(0));
+            return perm;
+        }
+
+        template <class It, class Perm>
+        Perm _argsort(It first, Perm perm) {
+            using bits_type = decltype(_ordered_bits(*first));
+            std::size_t n = perm.size();
+            std::pmr::memory_resource* resource = scratch_resource();
+            std::pmr::vector<bits_type> bits(n, resource), bits_tmp(n, resource);
+            std::pmr::vector<std::size_t> order(perm.begin(), perm.end(), resource), order_tmp(n, resource);
+            for (std::size_t i = 0; i < n; ++i) {
+                bits[i] = _ordered_bits(first[static_cast<std::ptrdiff_t>(order[i])]);
+            }
+
+            for (std::size_t shift = 0; shift < sizeof(bits_type) * 8; shift += 8) {
+                std::array<std::size_t, 256> count{};
+                for (bits_type b : bits) {
+                    ++count[(b >> shift) & 0xFF];
+                }
+                if (std::find(count.begin(), count.end(), n) != count.end()) continue;
+
+                std::size_t offset = 0;
+                for (std::size_t& c : count) {
+                    offset += std::exchange(c, offset);
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    std::size_t pos = count[(bits[i] >> shift) & 0xFF]++;
+                    bits_tmp[pos] = bits[i];
+                    order_tmp[pos] = order[i];
+                }
+                bits.swap(bits_tmp);
+                order.swap(order_tmp);
+            }
+            std::copy(order.begin(), order.end(), perm.begin());
+            return perm;
+        }
+
+        template <class It, class Perm>
+        void _gather(It first, const Perm& perm) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            std::pmr::vector<value_type> sorted(scratch_resource());
+            sorted.reserve(perm.size());
+            for (std::size_t i : perm) {
+                sorted.push_back(std::move(first[static_cast<std::ptrdiff_t>(i)]));
+            }
+            std::move(sorted.begin(), sorted.end(), first);
+        }
+    }
+
+    template <random_access_iterator KeyIt, random_access_iterator... ValueIt>
+    void sort_by_key(KeyIt keys_first, KeyIt keys_last, ValueIt... values_first) {
+        using key_type = typename std::iterator_traits<KeyIt>::value_type;
+        if constexpr (radix_impl::is_radix_key<key_type>::value) {
+            auto perm = radix_impl::_argsort(keys_first, radix_impl::_identity<std::pmr::vector<std::size_t>>(
+                static_cast<std::size_t>(keys_last - keys_first), scratch_resource()));
+            radix_impl::_gather(keys_first, perm);
+            (radix_impl::_gather(values_first, perm), ...);
+        } else {
+            auto n = keys_last - keys_first;
+            quicksort::sort(make_zip_iterator(keys_first, values_first...),
+                            make_zip_iterator(keys_last, (values_first + n)...),
+                            [](const auto& a, const auto& b) { return std::less<>()(std::get<0>(a), std::get<0>(b)); });
+        }
+    }
+
+    namespace table_impl {
+        constexpr std::size_t tile_size = std::size_t(1) << 12;
+
+        struct move_op {
+            std::size_t from;
+            std::size_t to;
+        };
+
+        template <class Perm>
+        std::pmr::vector<move_op> _block(const Perm& perm) {
+            std::pmr::vector<move_op> ops(perm.size(), scratch_resource());
+            for (std::size_t i = 0; i < perm.size(); ++i) {
+                ops[i] = {perm[i], i};
+            }
+            for (std::size_t t = 0; t < ops.size(); t += tile_size) {
+                auto tile = ops.begin() + static_cast<std::ptrdiff_t>(t);
+                auto tile_end = ops.begin() + static_cast<std::ptrdiff_t>(std::min(t + tile_size, ops.size()));
+                quicksort::sort(tile, tile_end, [](const move_op& a, const move_op& b) { return a.from < b.from; });
+            }
+            return ops;
+        }
+
+        template <class It>
+        void _apply(It column, const std::pmr::vector<move_op>& ops) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            auto n = static_cast<std::ptrdiff_t>(ops.size());
+            std::pmr::vector<value_type> source(std::make_move_iterator(column), std::make_move_iterator(column + n), scratch_resource());
+            for (const move_op& op : ops) {
+                column[static_cast<std::ptrdiff_t>(op.to)] = std::move(source[op.from]);
+            }
+        }
+
+        template <class It, class Compare>
+        struct index_compare {
+            It first;
+            Compare& comp;
+
+            bool operator()(std::size_t a, std::size_t b) const {
+                return static_cast<bool>(comp(first[static_cast<std::ptrdiff_t>(a)], first[static_cast<std::ptrdiff_t>(b)]));
+            }
+
+            const void* key_address(std::size_t i) const { return std::addressof(first[static_cast<std::ptrdiff_t>(i)]); }
+        };
+
+        template <class It, class Compare, class Perm>
+        Perm _argsort(It first, Compare& comp, Perm perm) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            if constexpr (radix_impl::is_default_ordering<value_type, Compare>::value) {
+                return radix_impl::_argsort(first, std::move(perm));
+            } else {
+                quicksort::sort(perm.begin(), perm.end(), index_compare<It, Compare>{first, comp});
+                return perm;
+            }
+        }
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    std::vector<std::size_t> argsort(It first, It last, Compare comp = {}) {
+        return table_impl::_argsort(first, comp, radix_impl::_identity(static_cast<std::size_t>(last - first)));
+    }
+
+    template <random_access_iterator PrimaryIt, random_access_iterator SecondaryIt>
+    std::vector<std::size_t> lexicographic_argsort(PrimaryIt primary_first, PrimaryIt primary_last, SecondaryIt secondary_first) {
+        using primary_type = typename std::iterator_traits<PrimaryIt>::value_type;
+        using secondary_type = typename std::iterator_traits<SecondaryIt>::value_type;
+        auto perm = radix_impl::_identity(static_cast<std::size_t>(primary_last - primary_first));
+        if constexpr (radix_impl::is_radix_key<primary_type>::value && radix_impl::is_radix_key<secondary_type>::value) {
+            return radix_impl::_argsort(primary_first, radix_impl::_argsort(secondary_first, std::move(perm)));
+        } else {
+            quicksort::sort(perm.begin(), perm.end(), [primary_first, secondary_first](std::size_t a, std::size_t b) {
+                const auto& pa = primary_first[static_cast<std::ptrdiff_t>(a)];
+                const auto& pb = primary_first[static_cast<std::ptrdiff_t>(b)];
+                if (pa < pb) return true;
+                if (pb < pa) return false;
+                return secondary_first[static_cast<std::ptrdiff_t>(a)] < secondary_first[static_cast<std::ptrdiff_t>(b)];
+            });
+            return perm;
+        }
+    }
+
+    template <random_access_iterator... Column>
+    void apply_permutation(const std::vector<std::size_t>& perm, Column... columns) {
+        auto ops = table_impl::_block(perm);
+        (table_impl::_apply(columns, ops), ...);
+    }
+
+    template <random_access_iterator KeyIt, random_access_iterator... Column>
+    void sort_table(KeyIt keys_first, KeyIt keys_last, Column... columns) {
+        std::less<> comp;
+        auto perm = table_impl::_argsort(keys_first, comp, radix_impl::_identity<std::pmr::vector<std::size_t>>(
+            static_cast<std::size_t>(keys_last - keys_first), scratch_resource()));
+        auto ops = table_impl::_block(perm);
+        table_impl::_apply(keys_first, ops);
+        (table_impl::_apply(columns, ops), ...);
+    }
+
+    namespace unique_impl {
+        constexpr std::ptrdiff_t insertion_threshold = 16;
+
+        template <class It, class Compare, class Emit>
+        void _emit_runs(It first, It last, Compare& comp, Emit& emit) {
+            using std::iter_swap;
+            for (It i = first + 1; i < last; ++i) {
+                for (It j = i; j != first && comp(*j, *(j - 1)); --j) {
+                    iter_swap(j, j - 1);
+                }
+            }
+            while (first != last) {
+                It next = first + 1;
+                while (next != last && !comp(*first, *next)) ++next;
+                emit(first, next);
+                first = next;
+            }
+        }
+
+        template <class It, class Compare, class Emit>
+        void _sort_runs(It first, It last, Compare& comp, Emit& emit) {
+            using std::iter_swap;
+            while (last - first > insertion_threshold) {
+                It mid = first + (last - first) / 2;
+                if (comp(*mid, *first)) iter_swap(mid, first);
+                if (comp(*(last - 1), *mid)) {
+                    iter_swap(last - 1, mid);
+                    if (comp(*mid, *first)) iter_swap(mid, first);
+                }
+                iter_swap(first, mid);
+
+                It lt = first, i = first + 1, gt = last;
+                while (i != gt) {
+                    if (comp(*i, *lt)) {
+                        iter_swap(lt++, i++);
+                    } else if (comp(*lt, *i)) {
+                        iter_swap(i, --gt);
+                    } else {
+                        ++i;
+                    }
+                }
+
+                _sort_runs(first, lt, comp, emit);
+                emit(lt, gt);
+                first = gt;
+            }
+            if (first != last) _emit_runs(first, last, comp, emit);
+        }
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    It sort_unique(It first, It last, Compare comp = {}) {
+        It out = first;
+        auto emit = [&out](It run_first, It) {
+            if (out != run_first) *out = std::ranges::iter_move(run_first);
+            ++out;
+        };
+        unique_impl::_sort_runs(first, last, comp, emit);
+        return out;
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    std::vector<std::pair<typename std::iterator_traits<It>::value_type, std::size_t>> sort_count(It first, It last, Compare comp = {}) {
+        std::vector<std::pair<typename std::iterator_traits<It>::value_type, std::size_t>> runs;
+        auto emit = [&runs](It run_first, It run_last) {
+            runs.emplace_back(*run_first, static_cast<std::size_t>(run_last - run_first));
+        };
+        unique_impl::_sort_runs(first, last, comp, emit);
+        return runs;
+    }
+
+    template <class T, class Compare = std::less<>>
+    class flat_multiset {
+    public:
+        using value_type = T;
+        using key_compare = Compare;
+        using size_type = std::size_t;
+        using const_iterator = typename std::vector<T>::const_iterator;
+        using iterator = const_iterator;
+
+        flat_multiset() = default;
+        explicit flat_multiset(Compare comp) : comp_(std::move(comp)) {}
+        template <std::input_iterator It>
+        flat_multiset(It first, It last, Compare comp = {}) : comp_(std::move(comp)) { insert(first, last); }
+        flat_multiset(std::initializer_list<T> values, Compare comp = {}) : comp_(std::move(comp)) { insert(values); }
+
+        const_iterator begin() const noexcept { return storage_.begin(); }
+        const_iterator end() const noexcept { return storage_.end(); }
+        const T* data() const noexcept { return storage_.data(); }
+        size_type size() const noexcept { return storage_.size(); }
+        bool empty() const noexcept { return storage_.empty(); }
+        key_compare key_comp() const { return comp_; }
+        void reserve(size_type n) { storage_.reserve(n); }
+        void clear() noexcept { storage_.clear(); }
+
+        iterator insert(const T& value) { return storage_.insert(upper_bound(value), value); }
+        iterator insert(T&& value) { return storage_.insert(upper_bound(value), std::move(value)); }
+
+        template <std::input_iterator It>
+        void insert(It first, It last) { _insert(first, last, false); }
+        void insert(std::initializer_list<T> values) { _insert(values.begin(), values.end(), false); }
+
+        template <std::input_iterator It>
+        void insert_unique(It first, It last) { _insert(first, last, true); }
+        void insert_unique(std::initializer_list<T> values) { _insert(values.begin(), values.end(), true); }
+
+        iterator erase(const_iterator pos) { return storage_.erase(pos); }
+        iterator erase(const_iterator first, const_iterator last) { return storage_.erase(first, last); }
+
+        template <class K>
+        iterator lower_bound(const K& key) const {
+            return _search([this, &key](const T& x) { return static_cast<bool>(comp_(x, key)); });
+        }
+
+        template <class K>
+        iterator upper_bound(const K& key) const {
+            return _search([this, &key](const T& x) { return !comp_(key, x); });
+        }
+
+        template <class K>
+        std::pair<iterator, iterator> equal_range(const K& key) const { return {lower_bound(key), upper_bound(key)}; }
+
+        template <class K>
+        iterator find(const K& key) const {
+            iterator it = lower_bound(key);
+            return it != end() && !comp_(key, *it) ? it : end();
+        }
+
+        template <class K>
+        bool contains(const K& key) const { return find(key) != end(); }
+
+        template <class K>
+        size_type count(const K& key) const {
+            auto [first, last] = equal_range(key);
+            return static_cast<size_type>(last - first);
+        }
+
+    private:
+        template <class Before>
+        iterator _search(Before before) const {
+            const T* base = storage_.data();
+            std::size_t n = storage_.size();
+            if (n == 0) return end();
+            while (n > 1) {
+                std::size_t half = n / 2;
+                base = before(base[half]) ? base + half : base;
+                n -= half;
+            }
+            return begin() + (base - storage_.data()) + (before(*base) ? 1 : 0);
+        }
+
+        template <class It>
+        void _insert(It first, It last, bool unique) {
+            auto n = static_cast<std::ptrdiff_t>(storage_.size());
+            storage_.insert(storage_.end(), first, last);
+            if (unique) {
+                storage_.erase(quicksort::sort_unique(storage_.begin() + n, storage_.end(), comp_), storage_.end());
+                _drop_existing(n);
+            } else {
+                quicksort::sort(storage_.begin() + n, storage_.end(), comp_);
+            }
+            _merge_tail(n);
+        }
+
+        void _drop_existing(std::ptrdiff_t n) {
+            auto mid = storage_.begin() + n;
+            if (mid == storage_.begin() || mid == storage_.end()) return;
+            auto old = std::lower_bound(storage_.begin(), mid, *mid, comp_);
+            auto out = mid;
+            for (auto in = mid; in != storage_.end(); ++in) {
+                while (old != mid && comp_(*old, *in)) ++old;
+                if (old != mid && !comp_(*in, *old)) continue;
+                if (out != in) *out = std::move(*in);
+                ++out;
+            }
+            storage_.erase(out, storage_.end());
+        }
+
+        void _merge_tail(std::ptrdiff_t n) {
+            auto mid = storage_.begin() + n;
+            if (mid == storage_.begin() || mid == storage_.end() || !comp_(*mid, *(mid - 1))) return;
+
+            auto lo = std::upper_bound(storage_.begin(), mid, *mid, comp_);
+            std::pmr::vector<T> batch(std::make_move_iterator(mid), std::make_move_iterator(storage_.end()), scratch_resource());
+            auto out = storage_.end();
+            auto a = mid;
+            auto b = batch.end();
+            while (b != batch.begin()) {
+                if (a != lo && comp_(*(b - 1), *(a - 1))) {
+                    *--out = std::move(*--a);
+                } else {
+                    *--out = std::move(*--b);
+                }
+            }
+        }
+
+        std::vector<T> storage_;
+        [[no_unique_address]] Compare comp_;
+    };
+
+    template <class T, class Compare = std::greater<>>
+    class topk_accumulator {
+    public:
+        explicit topk_accumulator(std::size_t k, Compare comp = {}) : k_(k), comp_(std::move(comp)) { buffer_.reserve(2 * k); }
+
+        std::size_t k() const noexcept { return k_; }
+
+        void push(const T& value) {
+            if (_admits(value)) _append(value);
+        }
+
+        void push(T&& value) {
+            if (_admits(value)) _append(std::move(value));
+        }
+
+        template <std::input_iterator It>
+        void push(It first, It last) {
+            for (; first != last; ++first) {
+                push(*first);
+            }
+        }
+
+        std::vector<T> sorted() const {
+            std::vector<T> result(buffer_);
+            if (result.size() > k_) {
+                random_access_impl::_select(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k_), result.end(), comp_);
+                result.resize(k_);
+            }
+            quicksort::sort(result.begin(), result.end(), comp_);
+            return result;
+        }
+
+    private:
+        bool _admits(const T& value) const { return k_ != 0 && (!full_ || comp_(value, buffer_[k_ - 1])); }
+
+        template <class U>
+        void _append(U&& value) {
+            buffer_.push_back(std::forward<U>(value));
+            if (buffer_.size() < 2 * k_) return;
+            random_access_impl::_select(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(k_ - 1), buffer_.end(), comp_);
+            buffer_.erase(buffer_.begin() + static_cast<std::ptrdiff_t>(k_), buffer_.end());
+            full_ = true;
+        }
+
+        std::size_t k_;
+        [[no_unique_address]] mutable Compare comp_;
+        std::vector<T> buffer_;
+        bool full_ = false;
+    };
+
+    struct slice_budget {
+        std::size_t comparisons = std::size_t(1) << 14;
+        std::chrono::nanoseconds time = std::chrono::nanoseconds::zero();
+    };
+
+    class sort_task {
+    public:
+        struct promise_type;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        struct yield_awaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(handle_type h) const noexcept {
+                auto continuation = std::exchange(h.promise().continuation, nullptr);
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        struct promise_type {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            sort_task get_return_object() { return sort_task(handle_type::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            yield_awaiter final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        sort_task(sort_task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+        sort_task& operator=(sort_task&& other) noexcept {
+            std::swap(handle_, other.handle_);
+            return *this;
+        }
+        ~sort_task() {
+            if (handle_) handle_.destroy();
+        }
+
+        bool done() const { return !handle_ || handle_.done(); }
+
+        bool resume() {
+            if (!done()) handle_.resume();
+            _rethrow();
+            return !done();
+        }
+
+        auto operator co_await() & {
+            struct awaiter {
+                sort_task& task;
+
+                bool await_ready() const { return task.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+                    task.handle_.promise().continuation = awaiting;
+                    return task.handle_;
+                }
+                bool await_resume() {
+                    task._rethrow();
+                    return task.done();
+                }
+            };
+            return awaiter{*this};
+        }
+
+    private:
+        explicit sort_task(handle_type handle) : handle_(handle) {}
+
+        void _rethrow() {
+            if (handle_ && handle_.promise().error) std::rethrow_exception(std::exchange(handle_.promise().error, nullptr));
+        }
+
+        handle_type handle_;
+    };
+
+    namespace resumable_impl {
+        constexpr std::size_t clock_interval = 64;
+
+        class meter {
+        public:
+            explicit meter(slice_budget budget) : budget_(budget) { restart(); }
+
+            void restart() {
+                used_ = 0;
+                next_clock_check_ = clock_interval;
+                if (budget_.time > std::chrono::nanoseconds::zero()) deadline_ = std::chrono::steady_clock::now() + budget_.time;
+            }
+
+            auto spend(std::size_t comparisons) {
+                used_ += comparisons;
+                struct awaiter : sort_task::yield_awaiter {
+                    meter& owner;
+                    bool exhausted;
+
+                    bool await_ready() const noexcept { return !exhausted; }
+                    void await_resume() const { if (exhausted) owner.restart(); }
+                };
+                return awaiter{{}, *this, _exhausted()};
+            }
+
+        private:
+            bool _exhausted() {
+                if (budget_.comparisons != 0 && used_ >= budget_.comparisons) return true;
+                if (budget_.time <= std::chrono::nanoseconds::zero() || used_ < next_clock_check_) return false;
+                next_clock_check_ = used_ + clock_interval;
+                return std::chrono::steady_clock::now() >= deadline_;
+            }
+
+            slice_budget budget_;
+            std::size_t used_ = 0;
+            std::size_t next_clock_check_ = 0;
+            std::chrono::steady_clock::time_point deadline_;
+        };
+    }
+
+    template <random_access_iterator It, class Compare = std::less<>>
+    sort_task resumable_sort(It first, It last, Compare comp = {}, slice_budget budget = {}) {
+        using std::iter_swap;
+        resumable_impl::meter meter(budget);
+        std::vector<std::pair<It, It>> stack;
+        stack.emplace_back(first, last);
+
+        while (!stack.empty()) {
+            auto [lo, hi] = stack.back();
+            stack.pop_back();
+            if (hi - lo < 2) continue;
+
+            It pivot_it = hi - 1;
+            It mid = lo + (hi - lo) / 2;
+            if (comp(*mid, *lo)) iter_swap(mid, lo);
+            if (comp(*pivot_it, *mid)) {
+                iter_swap(pivot_it, mid);
+                if (comp(*mid, *lo)) iter_swap(mid, lo);
+            }
+            iter_swap(mid, pivot_it);
+            co_await meter.spend(3);
+
+            It i = lo;
+            for (It j = lo; j != pivot_it; ++j) {
+                if (comp(*j, *pivot_it)) {
+                    iter_swap(i, j);
+                    ++i;
+                }
+                co_await meter.spend(1);
+            }
+            iter_swap(i, pivot_it);
+
+            if (i - lo < hi - i) {
+                stack.emplace_back(i + 1, hi);
+                stack.emplace_back(lo, i);
+            } else {
+                stack.emplace_back(lo, i);
+                stack.emplace_back(i + 1, hi);
+            }
+        }
+    }
+
+    namespace numa {
+        struct topology {
+            std::vector<std::vector<unsigned>> node_cpus;
+
+            std::size_t nodes() const { return node_cpus.size(); }
+        };
+
+        inline std::vector<unsigned> parse_cpulist(std::string_view list) {
+            std::vector<unsigned> cpus;
+            while (!list.empty()) {
+                std::size_t comma = list.find(',');
+                std::string_view range = list.substr(0, comma);
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+                std::size_t dash = range.find('-');
+                unsigned lo = 0, hi = 0;
+                std::from_chars(range.data(), range.data() + std::min(dash, range.size()), lo);
+                hi = lo;
+                if (dash != std::string_view::npos) {
+                    std::from_chars(range.data() + dash + 1, range.data() + range.size(), hi);
+                }
+                for (unsigned cpu = lo; cpu <= hi && !range.empty(); ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+        inline topology detect_topology() {
+            topology result;
+            std::error_code error;
+            std::vector<std::pair<unsigned, std::filesystem::path>> nodes;
+            for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+                std::string name = entry.path().filename().string();
+                unsigned id = 0;
+                if (name.rfind("node", 0) != 0) continue;
+                auto [end, ec] = std::from_chars(name.data() + 4, name.data() + name.size(), id);
+                if (ec != std::errc() || end != name.data() + name.size()) continue;
+                nodes.emplace_back(id, entry.path() / "cpulist");
+            }
+            std::sort(nodes.begin(), nodes.end());
+            for (const auto& node : nodes) {
+                std::ifstream in(node.second);
+                std::string list;
+                std::getline(in, list);
+                auto cpus = parse_cpulist(list);
+                if (!cpus.empty()) result.node_cpus.push_back(std::move(cpus));
+            }
+            if (result.node_cpus.empty()) {
+                result.node_cpus.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+                std::iota(result.node_cpus[0].begin(), result.node_cpus[0].end(), 0u);
+            }
+            return result;
+        }
+    }
+
+    namespace numa_impl {
+        struct state {
+            std::mutex lock;
+            bool simulated = false;
+            numa::topology simulated_topology;
+        };
+
+        inline state& _state() {
+            static state instance;
+            return instance;
+        }
+
+        inline const numa::topology& _detected() {
+            static const numa::topology detected = numa::detect_topology();
+            return detected;
+        }
+
+        struct placement {
+            std::vector<std::size_t> node;
+            std::vector<unsigned> cpu;
+            std::size_t nodes = 1;
+        };
+
+        struct affinity_guard {
+#if defined(__linux__)
+            cpu_set_t saved;
+            bool valid;
+
+            affinity_guard() : valid(pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0) {}
+            ~affinity_guard() {
+                if (valid) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+            }
+#endif
+        };
+
+        inline void _pin(unsigned cpu) {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)cpu;
+#endif
+        }
+    }
+
+    namespace numa {
+        inline void simulate_topology(std::size_t nodes, std::size_t cpus_per_node) {
+            nodes = std::max<std::size_t>(1, nodes);
+            cpus_per_node = std::max<std::size_t>(1, cpus_per_node);
+            topology simulated;
+            for (std::size_t node = 0; node < nodes; ++node) {
+                simulated.node_cpus.emplace_back(cpus_per_node);
+                std::iota(simulated.node_cpus.back().begin(), simulated.node_cpus.back().end(),
+                          static_cast<unsigned>(node * cpus_per_node));
+            }
+            auto& state = numa_impl::_state();
+            std::lock_guard<std::mutex> guard(state.lock);
+            state.simulated = true;
+            state.simulated_topology = std::move(simulated);
+        }
+
+        inline void clear_simulated_topology() {
+            auto& state = numa_impl::_state();
+            std::lock_guard<std::mutex> guard(state.lock);
+            state.simulated = false;
+        }
+
+        inline topology current_topology() {
+            auto& state = numa_impl::_state();
+            std::lock_guard<std::mutex> guard(state.lock);
+            return state.simulated ? state.simulated_topology : numa_impl::_detected();
+        }
+    }
+
+    namespace numa_impl {
+        inline placement _place(unsigned threads) {
+            numa::topology topo = numa::current_topology();
+            placement result;
+            result.nodes = std::max<std::size_t>(1, topo.nodes());
+            for (unsigned t = 0; t < threads; ++t) {
+                std::size_t node = std::size_t(t) * result.nodes / threads;
+                std::size_t first_on_node = (node * threads + result.nodes - 1) / result.nodes;
+                const auto& cpus = topo.node_cpus[node];
+                result.node.push_back(node);
+                result.cpu.push_back(cpus[(t - first_on_node) % cpus.size()]);
+            }
+            return result;
+        }
+    }
+
+    namespace parallel_impl {
+        constexpr std::ptrdiff_t sequential_threshold = std::ptrdiff_t(1) << 16;
+        constexpr std::size_t max_buckets = 128;
+        constexpr std::size_t oversampling = 16;
+        constexpr std::size_t block_bytes = 1024;
+        constexpr int max_depth = 8;
+
+        template <class T>
+        constexpr std::ptrdiff_t block_size = static_cast<std::ptrdiff_t>(std::max<std::size_t>(1, block_bytes / sizeof(T)));
+
+        inline unsigned _default_threads() {
+            unsigned threads = std::thread::hardware_concurrency();
+            return threads ? threads : 1;
+        }
+
+        template <class Fn>
+        void _run_team(const numa_impl::placement& place, Fn fn) {
+            auto threads = static_cast<unsigned>(place.cpu.size());
+            bool pin = place.nodes > 1;
+            std::vector<std::thread> team;
+            team.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                team.emplace_back([&fn, &place, pin, t] {
+                    if (pin) numa_impl::_pin(place.cpu[t]);
+                    fn(t);
+                });
+            }
+            {
+                numa_impl::affinity_guard guard;
+                if (pin) numa_impl::_pin(place.cpu[0]);
+                fn(0u);
+            }
+            for (std::thread& thread : team) {
+                thread.join();
+            }
+        }
+
+        template <class T, class Compare>
+        class classifier {
+        public:
+            classifier(std::vector<T> splitters, Compare& comp)
+                : sorted_(std::move(splitters)), comp_(comp) {
+                k_ = sorted_.size() + 1;
+                log_k_ = static_cast<unsigned>(std::countr_zero(k_));
+                tree_.resize(k_);
+                _build(1, 0, sorted_.size());
+            }
+
+            classifier(const classifier&) = delete;
+
+            std::size_t num_buckets() const { return 2 * k_; }
+
+            template <class U>
+            std::size_t operator()(const U& x) const {
+                std::size_t b = 1;
+                for (unsigned level = 0; level < log_k_; ++level) {
+                    b = 2 * b + static_cast<std::size_t>(comp_(*tree_[b], x));
+                }
+                b -= k_;
+                return 2 * b + static_cast<std::size_t>(b + 1 < k_ && !comp_(x, sorted_[b]));
+            }
+
+        private:
+            void _build(std::size_t node, std::size_t lo, std::size_t hi) {
+                if (lo >= hi) return;
+                std::size_t mid = lo + (hi - lo) / 2;
+                tree_[node] = &sorted_[mid];
+                _build(2 * node, lo, mid);
+                _build(2 * node + 1, mid + 1, hi);
+            }
+
+            std::vector<T> sorted_;
+            std::vector<const T*> tree_;
+            std::size_t k_;
+            unsigned log_k_;
+            Compare& comp_;
+        };
+
+        template <class It, class Compare>
+        auto _make_classifier(It first, std::ptrdiff_t n, Compare& comp) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            std::size_t target = std::clamp<std::size_t>(std::bit_floor(static_cast<std::size_t>(n) / 1024), 2, max_buckets);
+
+            std::minstd_rand gen(static_cast<std::minstd_rand::result_type>(n));
+            std::uniform_int_distribution<std::ptrdiff_t> pick(0, n - 1);
+            std::vector<value_type> sample;
+            sample.reserve(oversampling * target);
+            for (std::size_t i = 0; i < oversampling * target; ++i) {
+                sample.push_back(first[pick(gen)]);
+            }
+            quicksort::sort(sample.begin(), sample.end(), comp);
+
+            std::vector<value_type> splitters;
+            for (std::size_t i = 1; i < target; ++i) {
+                const value_type& candidate = sample[i * oversampling];
+                if (splitters.empty() || comp(splitters.back(), candidate)) splitters.push_back(candidate);
+            }
+            std::size_t k = std::bit_ceil(splitters.size() + 1);
+            while (splitters.size() + 1 < k) {
+                splitters.push_back(splitters.back());
+            }
+            return classifier<value_type, Compare>(std::move(splitters), comp);
+        }
+
+        template <class It, class Classifier>
+        std::vector<std::ptrdiff_t> _partition(It first, std::ptrdiff_t n, const Classifier& classify,
+                                               const numa_impl::placement& place) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            const auto threads = static_cast<unsigned>(place.cpu.size());
+            constexpr std::ptrdiff_t B = block_size<value_type>;
+            const std::size_t K = classify.num_buckets();
+
+            struct thread_state {
+                std::vector<std::vector<value_type>> buffers;
+                std::vector<std::ptrdiff_t> counts;
+                std::ptrdiff_t stripe_begin = 0;
+                std::ptrdiff_t filled_end = 0;
+            };
+            std::vector<thread_state> states(threads);
+            std::vector<std::ptrdiff_t> starts(K + 1), regions(K + 1), read(K), write(K), filled(K);
+            std::unique_ptr<std::mutex[]> locks(new std::mutex[K]);
+            std::vector<std::vector<value_type>> saved(K);
+            std::vector<value_type> overflow;
+            std::size_t overflow_bucket = K;
+            std::barrier sync(static_cast<std::ptrdiff_t>(threads));
+
+            auto block = [&](std::ptrdiff_t index) { return first + index * B; };
+            auto is_full = [&](std::ptrdiff_t index) {
+                auto owner = std::upper_bound(states.begin(), states.end(), index * B,
+                    [](std::ptrdiff_t pos, const thread_state& s) { return pos < s.stripe_begin; }) - 1;
+                return (index + 1) * B <= owner->filled_end;
+            };
+
+            _run_team(place, [&](unsigned t) {
+                thread_state& state = states[t];
+                state.buffers.resize(K);
+                state.counts.assign(K, 0);
+                for (auto& buffer : state.buffers) {
+                    buffer.reserve(static_cast<std::size_t>(B));
+                }
+
+                state.stripe_begin = n * t / threads / B * B;
+                std::ptrdiff_t stripe_end = t + 1 == threads ? n : n * (t + 1) / threads / B * B;
+                std::ptrdiff_t out = state.stripe_begin;
+                for (It it = first + state.stripe_begin, end = first + stripe_end; it != end; ++it) {
+                    std::size_t bucket = classify(*it);
+                    auto& buffer = state.buffers[bucket];
+                    buffer.push_back(std::move(*it));
+                    ++state.counts[bucket];
+                    if (static_cast<std::ptrdiff_t>(buffer.size()) == B) {
+                        std::move(buffer.begin(), buffer.end(), first + out);
+                        buffer.clear();
+                        out += B;
+                    }
+                }
+                state.filled_end = out;
+                sync.arrive_and_wait();
+
+                if (t == 0) {
+                    for (std::size_t b = 0; b < K; ++b) {
+                        std::ptrdiff_t count = 0, blocks = 0;
+                        for (const thread_state& s : states) {
+                            count += s.counts[b];
+                            blocks += (s.counts[b] - static_cast<std::ptrdiff_t>(s.buffers[b].size())) / B;
+                        }
+                        starts[b + 1] = starts[b] + count;
+                        filled[b] = blocks;
+                    }
+                    for (std::size_t b = 0; b <= K; ++b) {
+                        regions[b] = (starts[b] + B - 1) / B;
+                    }
+                }
+                sync.arrive_and_wait();
+
+                for (std::size_t b = K * t / threads; b < K * (t + 1) / threads; ++b) {
+                    std::ptrdiff_t lo = regions[b], hi = regions[b + 1] - 1, full = 0;
+                    for (std::ptrdiff_t i = lo; i <= hi; ++i) {
+                        full += is_full(i);
+                    }
+                    while (true) {
+                        while (lo <= hi && is_full(lo)) ++lo;
+                        while (hi > lo && !is_full(hi)) --hi;
+                        if (lo >= hi) break;
+                        std::move(block(hi), block(hi) + B, block(lo));
+                        ++lo;
+                        --hi;
+                    }
+                    write[b] = regions[b];
+                    read[b] = regions[b] + full - 1;
+                }
+                sync.arrive_and_wait();
+
+                std::vector<value_type> current, displaced;
+                current.reserve(static_cast<std::size_t>(B));
+                displaced.reserve(static_cast<std::size_t>(B));
+                for (std::size_t i = 0; i < K; ++i) {
+                    std::size_t b = (K * t / threads + i) % K;
+                    while (true) {
+                        {
+                            std::lock_guard<std::mutex> guard(locks[b]);
+                            if (read[b] < write[b]) break;
+                            std::ptrdiff_t slot = read[b]--;
+                            current.assign(std::make_move_iterator(block(slot)), std::make_move_iterator(block(slot) + B));
+                        }
+                        while (true) {
+                            std::size_t dest = classify(current.front());
+                            std::ptrdiff_t target;
+                            bool occupied;
+                            {
+                                std::lock_guard<std::mutex> guard(locks[dest]);
+                                target = write[dest]++;
+                                occupied = target <= read[dest];
+                            }
+                            if (occupied) {
+                                displaced.assign(std::make_move_iterator(block(target)), std::make_move_iterator(block(target) + B));
+                            }
+                            if ((target + 1) * B > n) {
+                                overflow = std::move(current);
+                                overflow_bucket = dest;
+                                current = std::vector<value_type>();
+                                current.reserve(static_cast<std::size_t>(B));
+                            } else {
+                                std::move(current.begin(), current.end(), block(target));
+                            }
+                            if (!occupied) break;
+                            current.swap(displaced);
+                        }
+                    }
+                }
+                sync.arrive_and_wait();
+
+                auto blocks_end = [&](std::size_t b) {
+                    return (write[b] - (b == overflow_bucket)) * B;
+                };
+                for (std::size_t b = K * t / threads; b < K * (t + 1) / threads; ++b) {
+                    if (blocks_end(b) > std::max(starts[b + 1], regions[b] * B)) {
+                        saved[b].assign(std::make_move_iterator(first + starts[b + 1]), std::make_move_iterator(first + blocks_end(b)));
+                    }
+                }
+                sync.arrive_and_wait();
+
+                for (std::size_t b = K * t / threads; b < K * (t + 1) / threads; ++b) {
+                    std::ptrdiff_t head = starts[b], head_end = std::min(regions[b] * B, starts[b + 1]);
+                    std::ptrdiff_t tail = blocks_end(b);
+                    auto fill = [&](std::vector<value_type>& source) {
+                        for (value_type& value : source) {
+                            std::ptrdiff_t pos = head < head_end ? head++ : tail++;
+                            first[pos] = std::move(value);
+                        }
+                    };
+                    fill(saved[b]);
+                    if (b == overflow_bucket) fill(overflow);
+                    for (thread_state& s : states) {
+                        fill(s.buffers[b]);
+                    }
+                }
+            });
+            return starts;
+        }
+
+        template <class It, class Compare>
+        void _sort(It first, It last, Compare& comp, unsigned threads, int depth) {
+            std::ptrdiff_t n = last - first;
+            if (threads <= 1 || n < sequential_threshold || depth > max_depth) {
+                quicksort::sort(first, last, comp);
+                return;
+            }
+
+            auto place = numa_impl::_place(threads);
+            auto classify = _make_classifier(first, n, comp);
+            auto starts = _partition(first, n, classify, place);
+
+            std::vector<std::vector<std::size_t>> local(place.nodes);
+            for (std::size_t b = 0; b + 1 < starts.size(); b += 2) {
+                std::ptrdiff_t len = starts[b + 1] - starts[b];
+                if (len > n / threads) {
+                    _sort(first + starts[b], first + starts[b + 1], comp, threads, depth + 1);
+                } else if (len > 1) {
+                    local[static_cast<std::size_t>(starts[b]) * place.nodes / static_cast<std::size_t>(n)].push_back(b);
+                }
+            }
+
+            std::unique_ptr<std::atomic<std::size_t>[]> next(new std::atomic<std::size_t>[place.nodes]());
+            _run_team(place, [&](unsigned t) {
+                for (std::size_t k = 0; k < place.nodes; ++k) {
+                    std::size_t node = (place.node[t] + k) % place.nodes;
+                    const auto& queue = local[node];
+                    for (std::size_t i = next[node]++; i < queue.size(); i = next[node]++) {
+                        quicksort::sort(first + starts[queue[i]], first + starts[queue[i] + 1], comp);
+                    }
+                }
+            });
+        }
+
+        constexpr std::ptrdiff_t merge_grain = std::ptrdiff_t(1) << 14;
+
+        template <class AIt, class BIt, class Compare>
+        std::ptrdiff_t _co_rank(std::ptrdiff_t diagonal, AIt a, std::ptrdiff_t na, BIt b, std::ptrdiff_t nb, Compare& comp) {
+            std::ptrdiff_t lo = std::max(std::ptrdiff_t(0), diagonal - nb);
+            std::ptrdiff_t hi = std::min(diagonal, na);
+            while (lo < hi) {
+                std::ptrdiff_t mid = lo + (hi - lo) / 2;
+                if (comp(b[diagonal - mid - 1], a[mid])) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            return lo;
+        }
+
+        template <class AIt, class BIt, class OutIt, class Compare>
+        void _merge(AIt a, std::ptrdiff_t na, BIt b, std::ptrdiff_t nb, OutIt out, Compare& comp, const numa_impl::placement& place) {
+            auto threads = static_cast<std::ptrdiff_t>(place.cpu.size());
+            std::ptrdiff_t n = na + nb;
+            _run_team(place, [&](unsigned t) {
+                std::ptrdiff_t d0 = n * t / threads;
+                std::ptrdiff_t d1 = n * (t + 1) / threads;
+                std::ptrdiff_t i0 = _co_rank(d0, a, na, b, nb, comp);
+                std::ptrdiff_t i1 = _co_rank(d1, a, na, b, nb, comp);
+                std::merge(a + i0, a + i1, b + (d0 - i0), b + (d1 - i1), out + d0, comp);
+            });
+        }
+
+        inline unsigned _merge_threads(std::ptrdiff_t n, unsigned threads) {
+            return static_cast<unsigned>(std::clamp<std::ptrdiff_t>(n / merge_grain, 1, std::max(threads, 1u)));
+        }
+    }
+
+    namespace parallel {
+        template <random_access_iterator It, class Compare = std::less<>>
+        void sort(It first, It last, Compare comp = {}, unsigned threads = parallel_impl::_default_threads()) {
+            if constexpr (std::contiguous_iterator<It>) {
+                auto p = std::to_address(first);
+                parallel_impl::_sort(p, p + (last - first), comp, threads, 0);
+            } else {
+                parallel_impl::_sort(first, last, comp, threads, 0);
+            }
+        }
+
+        template <random_access_iterator AIt, random_access_iterator BIt, random_access_iterator OutIt, class Compare = std::less<>>
+        OutIt merge(AIt a_first, AIt a_last, BIt b_first, BIt b_last, OutIt out, Compare comp = {},
+                    unsigned threads = parallel_impl::_default_threads()) {
+            std::ptrdiff_t na = a_last - a_first;
+            std::ptrdiff_t nb = b_last - b_first;
+            threads = parallel_impl::_merge_threads(na + nb, threads);
+            if (threads == 1) return std::merge(a_first, a_last, b_first, b_last, out, comp);
+            parallel_impl::_merge(a_first, na, b_first, nb, out, comp, numa_impl::_place(threads));
+            return out + (na + nb);
+        }
+
+        template <random_access_iterator It, class Compare = std::less<>>
+        void inplace_merge(It first, It middle, It last, Compare comp = {}, unsigned threads = parallel_impl::_default_threads()) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            std::ptrdiff_t n = last - first;
+            threads = parallel_impl::_merge_threads(n, threads);
+            if (threads == 1) {
+                std::inplace_merge(first, middle, last, comp);
+                return;
+            }
+
+            auto place = numa_impl::_place(threads);
+            std::pmr::memory_resource* resource = scratch_resource();
+            auto bytes = static_cast<std::size_t>(n) * sizeof(value_type);
+            auto* buffer = static_cast<value_type*>(resource->allocate(bytes, alignof(value_type)));
+            parallel_impl::_run_team(place, [&](unsigned t) {
+                std::ptrdiff_t lo = n * t / threads;
+                std::ptrdiff_t hi = n * (t + 1) / threads;
+                std::uninitialized_move(first + lo, first + hi, buffer + lo);
+            });
+            std::ptrdiff_t na = middle - first;
+            parallel_impl::_merge(buffer, na, buffer + na, n - na, first, comp, place);
+            std::destroy(buffer, buffer + n);
+            resource->deallocate(buffer, bytes, alignof(value_type));
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    namespace shm_impl {
+        constexpr std::size_t samples_per_process = 32;
+
+        struct header {
+            std::size_t size;
+            unsigned processes;
+            pthread_barrier_t barrier;
+        };
+
+        inline std::size_t _align_up(std::size_t offset, std::size_t alignment) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        template <class T>
+        struct layout {
+            std::size_t data, output, samples, sample_counts, counts, bytes;
+
+            layout(std::size_t n, unsigned processes) {
+                data = _align_up(sizeof(header), alignof(T));
+                output = _align_up(data + n * sizeof(T), alignof(T));
+                samples = _align_up(output + n * sizeof(T), alignof(T));
+                sample_counts = _align_up(samples + processes * samples_per_process * sizeof(T), alignof(std::size_t));
+                counts = sample_counts + processes * sizeof(std::size_t);
+                bytes = counts + std::size_t(processes) * processes * sizeof(std::size_t);
+            }
+        };
+
+        inline void _throw_errno(const char* what) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        inline void* _map(int fd, std::size_t bytes) {
+            void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED) _throw_errno("mmap");
+            return base;
+        }
+    }
+
+    namespace shm {
+        template <class T>
+        class sample_sort_segment {
+            static_assert(std::is_trivially_copyable_v<T>, "shared-memory sample sort needs trivially copyable elements");
+
+        public:
+            static sample_sort_segment create(const std::string& name, std::size_t size, unsigned processes) {
+                shm_impl::layout<T> layout(size, processes);
+                int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+                if (fd < 0) shm_impl::_throw_errno("shm_open");
+                if (ftruncate(fd, static_cast<off_t>(layout.bytes)) != 0) {
+                    int error = errno;
+                    close(fd);
+                    shm_unlink(name.c_str());
+                    throw std::system_error(error, std::generic_category(), "ftruncate");
+                }
+                sample_sort_segment segment(name, shm_impl::_map(fd, layout.bytes), layout.bytes, true);
+
+                auto* h = new (segment.base_) shm_impl::header{size, processes, {}};
+                pthread_barrierattr_t attr;
+                pthread_barrierattr_init(&attr);
+                pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+                pthread_barrier_init(&h->barrier, &attr, processes);
+                pthread_barrierattr_destroy(&attr);
+                return segment;
+            }
+
+            static sample_sort_segment open(const std::string& name) {
+                int fd = shm_open(name.c_str(), O_RDWR, 0600);
+                if (fd < 0) shm_impl::_throw_errno("shm_open");
+                struct stat st;
+                if (fstat(fd, &st) != 0) {
+                    close(fd);
+                    shm_impl::_throw_errno("fstat");
+                }
+                auto bytes = static_cast<std::size_t>(st.st_size);
+                return sample_sort_segment(name, shm_impl::_map(fd, bytes), bytes, false);
+            }
+
+            sample_sort_segment(sample_sort_segment&& other) noexcept
+                : name_(std::move(other.name_)), base_(std::exchange(other.base_, nullptr)),
+                  bytes_(other.bytes_), owner_(std::exchange(other.owner_, false)) {}
+
+            sample_sort_segment& operator=(sample_sort_segment&& other) noexcept {
+                std::swap(name_, other.name_);
+                std::swap(base_, other.base_);
+                std::swap(bytes_, other.bytes_);
+                std::swap(owner_, other.owner_);
+                return *this;
+            }
+
+            ~sample_sort_segment() {
+                if (!base_) return;
+                if (owner_) {
+                    pthread_barrier_destroy(&_header().barrier);
+                    shm_unlink(name_.c_str());
+                }
+                munmap(base_, bytes_);
+            }
+
+            T* data() { return _array<T>(_layout().data); }
+            std::size_t size() const { return _header().size; }
+            unsigned processes() const { return _header().processes; }
+
+            template <class Compare = std::less<>>
+            void sort(unsigned rank, Compare comp = {}) {
+                const std::size_t n = size();
+                const unsigned p = processes();
+                const auto layout = _layout();
+                T* input = data();
+                T* output = _array<T>(layout.output);
+                T* samples = _array<T>(layout.samples);
+                std::size_t* sample_counts = _array<std::size_t>(layout.sample_counts);
+                std::size_t* counts = _array<std::size_t>(layout.counts);
+
+                T* slice = input + n * rank / p;
+                T* slice_end = input + n * (rank + 1) / p;
+                auto len = static_cast<std::size_t>(slice_end - slice);
+                quicksort::sort(slice, slice_end, comp);
+
+                std::size_t sampled = std::min(len, shm_impl::samples_per_process);
+                for (std::size_t k = 0; k < sampled; ++k) {
+                    samples[rank * shm_impl::samples_per_process + k] = slice[(2 * k + 1) * len / (2 * sampled)];
+                }
+                sample_counts[rank] = sampled;
+                _wait();
+
+                std::vector<T> gathered;
+                for (unsigned r = 0; r < p; ++r) {
+                    gathered.insert(gathered.end(), samples + r * shm_impl::samples_per_process,
+                                    samples + r * shm_impl::samples_per_process + sample_counts[r]);
+                }
+                quicksort::sort(gathered.begin(), gathered.end(), comp);
+                T* bound = slice;
+                for (unsigned d = 0; d < p; ++d) {
+                    T* next = slice_end;
+                    if (d + 1 < p && !gathered.empty()) {
+                        next = std::lower_bound(bound, slice_end, gathered[(d + 1) * gathered.size() / p], comp);
+                    }
+                    counts[rank * p + d] = static_cast<std::size_t>(next - bound);
+                    bound = next;
+                }
+                _wait();
+
+                std::size_t out_offset = 0;
+                std::vector<std::pair<T*, T*>> pieces;
+                for (unsigned src = 0; src < p; ++src) {
+                    std::size_t piece_offset = 0;
+                    for (unsigned d = 0; d < p; ++d) {
+                        if (d < rank) {
+                            out_offset += counts[src * p + d];
+                            piece_offset += counts[src * p + d];
+                        }
+                    }
+                    T* piece = input + n * src / p + piece_offset;
+                    if (counts[src * p + rank] > 0) pieces.emplace_back(piece, piece + counts[src * p + rank]);
+                }
+
+                auto heap_comp = [&comp](const std::pair<T*, T*>& a, const std::pair<T*, T*>& b) {
+                    return comp(*b.first, *a.first);
+                };
+                std::make_heap(pieces.begin(), pieces.end(), heap_comp);
+                T* out = output + out_offset;
+                while (!pieces.empty()) {
+                    std::pop_heap(pieces.begin(), pieces.end(), heap_comp);
+                    *out++ = *pieces.back().first++;
+                    if (pieces.back().first == pieces.back().second) {
+                        pieces.pop_back();
+                    } else {
+                        std::push_heap(pieces.begin(), pieces.end(), heap_comp);
+                    }
+                }
+                _wait();
+
+                std::copy(output + out_offset, out, input + out_offset);
+                _wait();
+            }
+
+        private:
+            sample_sort_segment(std::string name, void* base, std::size_t bytes, bool owner)
+                : name_(std::move(name)), base_(base), bytes_(bytes), owner_(owner) {}
+
+            shm_impl::header& _header() const { return *static_cast<shm_impl::header*>(base_); }
+            shm_impl::layout<T> _layout() const { return {size(), processes()}; }
+
+            template <class U>
+            U* _array(std::size_t offset) const {
+                return reinterpret_cast<U*>(static_cast<char*>(base_) + offset);
+            }
+
+            void _wait() {
+                pthread_barrier_wait(&_header().barrier);
+            }
+
+            std::string name_;
+            void* base_;
+            std::size_t bytes_;
+            bool owner_;
+        };
     }
+#endif
 }
 
 #endif //QUICKSORT_H
@@ -0,0 +1,11 @@
+#ifdef USE_CONCEPTS
+    #include "quicksort.h"
+#else
+    #include "quicksort_SFINAE.h"
+#endif
+
+namespace quicksort::random_access_impl {
+#define QUICKSORT_INSTANTIATE_DISPATCH(T) template void _dispatch<T*, std::less<>>(T*, T*, std::less<>);
+    QUICKSORT_INSTANTIATION_TYPES(QUICKSORT_INSTANTIATE_DISPATCH)
+#undef QUICKSORT_INSTANTIATE_DISPATCH
+}
@@ -6,8 +6,21 @@
 #include <random>
 #include <array>
 #include <deque>
+#include <list>
+#include <forward_list>
+#include <coroutine>
+#include <memory_resource>
+#include <map>
+#include <set>
+#include <span>
+#include <string_view>
 
 
+#if defined(__unix__)
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
 #if defined(USE_CONCEPTS)
     #include "quicksort.h"
 #else
@@ -273,6 +286,886 @@ TEST(QuicksortCustomTypeTest, SortPeopleByAge) {
     EXPECT_TRUE(std::is_sorted(people.begin(), people.end(), by_age));
 }
 
+TEST(QuicksortContiguousTest, SpanAndSubrange) {
+    std::vector<int> vec = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+    std::span<int> middle(vec.data() + 2, 6);
+
+    quicksort::sort(middle.begin(), middle.end());
+    EXPECT_TRUE(std::is_sorted(middle.begin(), middle.end()));
+    EXPECT_EQ(vec.front(), 9);
+    EXPECT_EQ(vec.back(), 0);
+
+    quicksort::sort(vec.begin(), vec.end());
+    EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+}
+
+constexpr Array<int> make_sorted_table() {
+    Array<int> table = {255, 2, 13, 144, 9, 4, 55, 6, 1, 89, 34};
+    quicksort::sort(table.begin(), table.end());
+    return table;
+}
+
+constexpr std::array<std::string_view, 6> make_keyword_list() {
+    std::array<std::string_view, 6> keywords = {"while", "auto", "return", "if", "do", "for"};
+    quicksort::sort(keywords.begin(), keywords.end());
+    return keywords;
+}
+
+constexpr auto sorted_table = make_sorted_table();
+constexpr auto keyword_list = make_keyword_list();
+static_assert(std::is_sorted(sorted_table.begin(), sorted_table.end()));
+static_assert(sorted_table.front() == 1 && sorted_table.back() == 255);
+static_assert(std::is_sorted(keyword_list.begin(), keyword_list.end()));
+static_assert(keyword_list.front() == "auto");
+
+TEST(QuicksortConstexprTest, DescendingTable) {
+    constexpr auto table = [] {
+        Array<double> t = {5.5, 2.2, 8.8, 3.3, 9.9, 4.4, 7.7, 6.6, 1.1, 0.0, 10.1};
+        quicksort::sort(t.begin(), t.end(), std::greater<>());
+        return t;
+    }();
+    EXPECT_TRUE(std::is_sorted(table.begin(), table.end(), std::greater<>()));
+}
+
+template <std::size_t N>
+void check_network_sorts() {
+    std::default_random_engine gen(static_cast<unsigned>(N));
+    std::uniform_int_distribution<> distrib(-50, 50);
+    for (int round = 0; round < 200; ++round) {
+        std::array<int, N> arr;
+        for (int& i : arr) {
+            i = distrib(gen);
+        }
+        quicksort::sort(arr);
+        EXPECT_TRUE(std::is_sorted(arr.begin(), arr.end())) << "N = " << N;
+    }
+}
+
+template <std::size_t... N>
+void check_network_sizes(std::index_sequence<N...>) {
+    (check_network_sorts<N>(), ...);
+}
+
+TEST(QuicksortNetworkTest, AllSizesUpToLimit) {
+    check_network_sizes(std::make_index_sequence<34>{});
+    check_network_sorts<40>();
+}
+
+TEST(QuicksortNetworkTest, ZeroOnePrinciple) {
+    for (unsigned mask = 0; mask < (1u << 11); ++mask) {
+        Array<int> arr;
+        for (std::size_t i = 0; i < arr.size(); ++i) {
+            arr[i] = static_cast<int>((mask >> i) & 1u);
+        }
+        quicksort::sort(arr);
+        ASSERT_TRUE(std::is_sorted(arr.begin(), arr.end())) << "mask = " << mask;
+    }
+}
+
+TEST(QuicksortNetworkTest, CustomComparatorAndType) {
+    Array<float> values = {8.8f, 2.2f, 5.5f, 3.3f, 9.9f, 4.4f, 7.7f, 6.6f, 1.1f, 0.5f, 10.0f};
+    quicksort::sort(values, std::greater<>());
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end(), std::greater<>()));
+
+    std::array<Person, 4> people = {{{"Eve", 30}, {"Alice", 25}, {"Charlie", 35}, {"Bob", 20}}};
+    quicksort::sort(people);
+    EXPECT_TRUE(std::is_sorted(people.begin(), people.end()));
+    EXPECT_EQ(people.front().name, "Bob");
+}
+
+TEST(QuicksortStringTest, SharedPrefixes) {
+    std::default_random_engine gen(7);
+    std::uniform_int_distribution<> distrib(0, 5);
+    const std::string prefixes[] = {"https://example.com/", "https://example.com/api/v1/", "/usr/local/lib/", ""};
+
+    std::vector<std::string> paths(3000);
+    for (std::string& path : paths) {
+        path = prefixes[distrib(gen) % 4];
+        int segments = distrib(gen);
+        for (int i = 0; i < segments; ++i) {
+            path += static_cast<char>('a' + distrib(gen));
+            path += static_cast<char>(distrib(gen) == 0 ? '\xe9' : '/');
+        }
+    }
+    std::vector<std::string> expected = paths;
+    std::sort(expected.begin(), expected.end());
+
+    quicksort::sort(paths.begin(), paths.end());
+    EXPECT_EQ(paths, expected);
+}
+
+TEST(QuicksortStringTest, StringViewsInDeque) {
+    std::deque<std::string_view> words = {"banana", "band", "ban", "", "bandana", "apple", "b", "ban", "z"};
+    std::vector<std::string_view> expected(words.begin(), words.end());
+    std::sort(expected.begin(), expected.end());
+
+    quicksort::sort(words.begin(), words.end(), std::less<std::string_view>());
+    EXPECT_TRUE(std::equal(words.begin(), words.end(), expected.begin(), expected.end()));
+}
+
+TEST(QuicksortPrefixTest, SortPeopleByName) {
+    std::vector<Person> people = {
+        {"Charlotte", 31}, {"Charles", 40}, {"Alice", 25}, {"Charlotte", 29},
+        {"Bob", 20}, {"Charleston", 33}, {"", 50}, {"Al", 60}
+    };
+    auto by_name = [](const Person& a, const Person& b) {
+        return a.name < b.name;
+    };
+
+    quicksort::sort_by_prefix(people.begin(), people.end(),
+        [](const Person& p) { return quicksort::string_prefix(p.name); }, by_name);
+    EXPECT_TRUE(std::is_sorted(people.begin(), people.end(), by_name));
+    EXPECT_EQ(people.size(), 8u);
+}
+
+TEST(QuicksortPrefixTest, CompoundKey) {
+    std::default_random_engine gen(42);
+    std::uniform_int_distribution<> distrib(0, 30);
+
+    std::vector<Person> people(2000);
+    for (Person& p : people) {
+        p.age = distrib(gen);
+        p.name = "user_" + std::to_string(distrib(gen) * distrib(gen));
+    }
+    auto by_age_then_name = [](const Person& a, const Person& b) {
+        return a.age != b.age ? a.age < b.age : a.name < b.name;
+    };
+    auto prefix = [](const Person& p) {
+        return static_cast<std::uint64_t>(p.age) << 32 | quicksort::string_prefix(p.name) >> 32;
+    };
+
+    quicksort::sort_by_prefix(people.begin(), people.end(), prefix, by_age_then_name);
+    EXPECT_TRUE(std::is_sorted(people.begin(), people.end(), by_age_then_name));
+}
+
+TEST(QuicksortListTest, ListAndForwardList) {
+    std::default_random_engine gen(11);
+    std::uniform_int_distribution<> distrib(-1000, 1000);
+
+    for (std::size_t size : {0u, 1u, 2u, 3u, 7u, 64u, 1000u}) {
+        std::list<int> list;
+        std::forward_list<int> forward_list;
+        for (std::size_t i = 0; i < size; ++i) {
+            list.push_back(distrib(gen));
+            forward_list.push_front(distrib(gen));
+        }
+
+        quicksort::sort(list);
+        quicksort::sort(forward_list, std::greater<>());
+        EXPECT_EQ(list.size(), size);
+        EXPECT_EQ(static_cast<std::size_t>(std::distance(forward_list.begin(), forward_list.end())), size);
+        EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+        EXPECT_TRUE(std::is_sorted(forward_list.begin(), forward_list.end(), std::greater<>()));
+    }
+}
+
+TEST(QuicksortListTest, ListSortIsStable) {
+    std::list<Person> people = {{"Eve", 30}, {"Alice", 25}, {"Charlie", 30}, {"Bob", 25}, {"Dan", 30}};
+    quicksort::sort(people);
+    std::vector<std::string> names;
+    for (const Person& p : people) {
+        names.push_back(p.name);
+    }
+    EXPECT_EQ(names, (std::vector<std::string>{"Alice", "Bob", "Eve", "Charlie", "Dan"}));
+}
+
+TEST(QuicksortListTest, ForwardIteratorsThroughBuffer) {
+    std::list<double> list = {5.5, 2.2, 8.8, 3.3, 9.9, 4.4, 7.7, 6.6, 1.1};
+    quicksort::sort(list.begin(), list.end());
+    EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+
+    std::forward_list<std::string> words = {"pear", "apple", "fig", "banana"};
+    quicksort::sort(words.begin(), words.end());
+    EXPECT_TRUE(std::is_sorted(words.begin(), words.end()));
+}
+
+TEST(QuicksortSortByKeyTest, ArithmeticKeysUseRadix) {
+    std::default_random_engine gen(5);
+    std::uniform_real_distribution<double> distrib(-1000.0, 1000.0);
+
+    std::vector<double> keys(4000);
+    std::vector<int> ids(keys.size());
+    std::vector<std::string> labels(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = i % 7 == 0 ? 0.0 : distrib(gen);
+        ids[i] = static_cast<int>(i);
+        labels[i] = std::to_string(keys[i]);
+    }
+    std::vector<double> original = keys;
+
+    quicksort::sort_by_key(keys.begin(), keys.end(), ids.begin(), labels.begin());
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(original[static_cast<std::size_t>(ids[i])], keys[i]);
+        EXPECT_EQ(labels[i], std::to_string(keys[i]));
+    }
+}
+
+TEST(QuicksortSortByKeyTest, SignedAndStringKeys) {
+    std::vector<short> keys = {5, -2, 8, -3, 9, 4, -7, 6, 1};
+    std::deque<char> values = {'e', 'b', 'h', 'c', 'i', 'd', 'a', 'f', 'g'};
+    quicksort::sort_by_key(keys.begin(), keys.end(), values.begin());
+    EXPECT_EQ(keys, (std::vector<short>{-7, -3, -2, 1, 4, 5, 6, 8, 9}));
+    EXPECT_EQ(values, (std::deque<char>{'a', 'c', 'b', 'g', 'd', 'e', 'f', 'h', 'i'}));
+
+    std::vector<std::string> names = {"Eve", "Alice", "Charlie", "Bob"};
+    std::vector<int> ages = {30, 25, 35, 20};
+    quicksort::sort_by_key(names.begin(), names.end(), ages.begin());
+    EXPECT_EQ(names, (std::vector<std::string>{"Alice", "Bob", "Charlie", "Eve"}));
+    EXPECT_EQ(ages, (std::vector<int>{25, 20, 35, 30}));
+}
+
+TEST(QuicksortSortByKeyTest, ZipIteratorWithComparator) {
+    std::vector<int> keys = {3, 1, 2};
+    std::vector<float> values = {3.5f, 1.5f, 2.5f};
+    quicksort::sort(quicksort::make_zip_iterator(keys.begin(), values.begin()),
+                    quicksort::make_zip_iterator(keys.end(), values.end()),
+                    [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+    EXPECT_EQ(keys, (std::vector<int>{3, 2, 1}));
+    EXPECT_EQ(values, (std::vector<float>{3.5f, 2.5f, 1.5f}));
+}
+
+TEST(QuicksortTableTest, WideTableBySingleKey) {
+    std::default_random_engine gen(99);
+    std::uniform_int_distribution<> distrib(-100000, 100000);
+
+    const std::size_t rows = 10000;
+    std::vector<int> keys(rows);
+    std::vector<long> row_ids(rows);
+    std::vector<std::string> names(rows);
+    std::vector<double> scores(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        keys[i] = distrib(gen);
+        row_ids[i] = static_cast<long>(i);
+        names[i] = "row" + std::to_string(i);
+        scores[i] = keys[i] * 0.5;
+    }
+    std::vector<int> original = keys;
+
+    quicksort::sort_table(keys.begin(), keys.end(), row_ids.begin(), names.begin(), scores.begin());
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (std::size_t i = 0; i < rows; ++i) {
+        auto id = static_cast<std::size_t>(row_ids[i]);
+        EXPECT_EQ(original[id], keys[i]);
+        EXPECT_EQ(names[i], "row" + std::to_string(id));
+        EXPECT_EQ(scores[i], keys[i] * 0.5);
+    }
+}
+
+TEST(QuicksortTableTest, CompositeKeys) {
+    std::vector<int> region = {2, 1, 2, 1, 3, 1, 2};
+    std::vector<float> price = {5.0f, 9.0f, 1.0f, 3.0f, 0.5f, 3.0f, 7.0f};
+    std::vector<std::string> city = {"b", "a", "c", "a", "d", "a", "b"};
+    std::vector<std::string> item = {"x", "y", "z", "w", "v", "u", "t"};
+    std::vector<std::string> tag = item;
+
+    auto perm = quicksort::lexicographic_argsort(region.begin(), region.end(), price.begin());
+    quicksort::apply_permutation(perm, region.begin(), price.begin(), item.begin());
+    EXPECT_EQ(region, (std::vector<int>{1, 1, 1, 2, 2, 2, 3}));
+    EXPECT_EQ(price, (std::vector<float>{3.0f, 3.0f, 9.0f, 1.0f, 5.0f, 7.0f, 0.5f}));
+    EXPECT_EQ(item, (std::vector<std::string>{"w", "u", "y", "z", "x", "t", "v"}));
+
+    auto by_city = quicksort::lexicographic_argsort(city.begin(), city.end(), tag.begin());
+    quicksort::apply_permutation(by_city, city.begin(), tag.begin());
+    EXPECT_EQ(city, (std::vector<std::string>{"a", "a", "a", "b", "b", "c", "d"}));
+    EXPECT_EQ(tag, (std::vector<std::string>{"u", "w", "y", "t", "x", "z", "v"}));
+}
+
+TEST(QuicksortAdaptiveTest, ConcatenatedRuns) {
+    std::default_random_engine gen(3);
+    std::uniform_int_distribution<> distrib(-100000, 100000);
+
+    for (int shards : {1, 2, 5, 40}) {
+        std::vector<int> vec;
+        for (int s = 0; s < shards; ++s) {
+            std::vector<int> shard(20000 / static_cast<std::size_t>(shards));
+            for (int& i : shard) {
+                i = distrib(gen);
+            }
+            std::sort(shard.begin(), shard.end());
+            if (s % 3 == 2) {
+                std::reverse(shard.begin(), shard.end());
+            }
+            vec.insert(vec.end(), shard.begin(), shard.end());
+        }
+        quicksort::sort(vec.begin(), vec.end());
+        EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end())) << "shards = " << shards;
+    }
+}
+
+TEST(QuicksortAdaptiveTest, StableOnRandomData) {
+    std::default_random_engine gen(8);
+    std::uniform_int_distribution<> distrib(0, 50);
+
+    std::vector<Person> people(5000);
+    for (std::size_t i = 0; i < people.size(); ++i) {
+        people[i] = {std::to_string(i), distrib(gen)};
+    }
+    std::vector<Person> expected = people;
+    std::stable_sort(expected.begin(), expected.end());
+
+    quicksort::adaptive_sort(people.begin(), people.end());
+    ASSERT_EQ(people.size(), expected.size());
+    for (std::size_t i = 0; i < people.size(); ++i) {
+        EXPECT_EQ(people[i].name, expected[i].name);
+    }
+}
+
+TEST(QuicksortAdaptiveTest, DescendingAndAllSameLargeInput) {
+    std::deque<double> descending(100000);
+    for (std::size_t i = 0; i < descending.size(); ++i) {
+        descending[i] = -static_cast<double>(i) * 0.25;
+    }
+    quicksort::sort(descending.begin(), descending.end());
+    EXPECT_TRUE(std::is_sorted(descending.begin(), descending.end()));
+
+    std::vector<long> same(100000, 777L);
+    quicksort::sort(same.begin(), same.end(), std::greater<>());
+    EXPECT_TRUE(std::all_of(same.begin(), same.end(), [](long x) { return x == 777L; }));
+}
+
+TYPED_TEST(QuicksortTypedTest, BatchOfFixedSizeArrays) {
+    using paramtype = typename TypeParam::value_type;
+    std::default_random_engine gen(17);
+    std::uniform_int_distribution<> distrib(0, 120);
+
+    std::vector<Array<paramtype>> arrays(53);
+    for (auto& arr : arrays) {
+        for (auto& x : arr) {
+            x = static_cast<paramtype>(distrib(gen));
+        }
+    }
+    std::vector<Array<paramtype>> descending = arrays;
+
+    quicksort::batch_sort(arrays.begin(), arrays.end());
+    quicksort::batch_sort(descending.begin(), descending.end(), std::greater<>());
+    for (std::size_t i = 0; i < arrays.size(); ++i) {
+        EXPECT_TRUE(std::is_sorted(arrays[i].begin(), arrays[i].end()));
+        EXPECT_TRUE(std::is_sorted(descending[i].begin(), descending[i].end(), std::greater<>()));
+        EXPECT_TRUE(std::equal(arrays[i].begin(), arrays[i].end(), descending[i].rbegin()));
+    }
+}
+
+TEST(QuicksortBatchTest, LargeAndNonTrivialArrays) {
+    std::vector<std::array<int, 40>> wide(3);
+    for (auto& arr : wide) {
+        for (std::size_t k = 0; k < arr.size(); ++k) {
+            arr[k] = static_cast<int>((k * 37) % 41);
+        }
+    }
+    quicksort::batch_sort(wide.begin(), wide.end());
+
+    std::deque<std::array<std::string, 3>> words = {{"c", "a", "b"}, {"z", "y", "x"}};
+    quicksort::batch_sort(words.begin(), words.end());
+    EXPECT_TRUE(std::is_sorted(wide[2].begin(), wide[2].end()));
+    EXPECT_EQ(words[1], (std::array<std::string, 3>{"x", "y", "z"}));
+}
+
+TEST(QuicksortPrefetchTest, LargePointerAndArgsortRanges) {
+    std::default_random_engine gen(55);
+    std::uniform_int_distribution<> distrib(-1000000, 1000000);
+    std::vector<int> values(600000);
+    for (int& v : values) {
+        v = distrib(gen);
+    }
+
+    std::vector<const int*> pointers(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        pointers[i] = &values[i];
+    }
+    auto by_pointee = [](const int* a, const int* b) { return *a < *b; };
+    quicksort::sort(pointers.begin(), pointers.end(), by_pointee);
+    EXPECT_TRUE(std::is_sorted(pointers.begin(), pointers.end(), by_pointee));
+
+    auto perm = quicksort::argsort(values.begin(), values.end(), std::greater<>());
+    EXPECT_TRUE(std::is_sorted(perm.begin(), perm.end(), [&values](std::size_t a, std::size_t b) {
+        return values[a] > values[b];
+    }));
+}
+
+TEST(QuicksortParallelTest, RandomAndSkewedData) {
+    std::default_random_engine gen(31);
+    std::uniform_int_distribution<> wide(-1000000, 1000000);
+    std::uniform_int_distribution<> narrow(0, 1000);
+
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+        std::vector<int> vec(300001);
+        for (std::size_t i = 0; i < vec.size(); ++i) {
+            vec[i] = i % 4 == 0 ? wide(gen) : narrow(gen);
+        }
+        std::vector<int> expected = vec;
+        std::sort(expected.begin(), expected.end());
+
+        quicksort::parallel::sort(vec.begin(), vec.end(), std::less<>(), threads);
+        EXPECT_EQ(vec, expected) << "threads = " << threads;
+    }
+}
+
+TEST(QuicksortParallelTest, HeavyElementsInDeque) {
+    std::default_random_engine gen(32);
+    std::uniform_int_distribution<> distrib(0, 1000000);
+
+    std::deque<std::string> words(100000);
+    for (std::string& word : words) {
+        word = std::to_string(distrib(gen));
+    }
+    std::vector<std::string> expected(words.begin(), words.end());
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+
+    quicksort::parallel::sort(words.begin(), words.end(), std::greater<>(), 4);
+    EXPECT_TRUE(std::equal(words.begin(), words.end(), expected.begin(), expected.end()));
+
+    std::vector<double> same(200000, 2.5);
+    quicksort::parallel::sort(same.begin(), same.end());
+    EXPECT_TRUE(std::all_of(same.begin(), same.end(), [](double x) { return x == 2.5; }));
+}
+
+TEST(QuicksortParallelTest, MergePathMergeIsStable) {
+    std::default_random_engine gen(51);
+    std::uniform_int_distribution<> distrib(0, 5000);
+    std::vector<std::pair<int, int>> a(70000), b(50000);
+    for (auto& x : a) {
+        x = {distrib(gen), 0};
+    }
+    for (auto& x : b) {
+        x = {distrib(gen), 1};
+    }
+    auto by_key = [](const auto& x, const auto& y) { return x.first < y.first; };
+    std::sort(a.begin(), a.end(), by_key);
+    std::sort(b.begin(), b.end(), by_key);
+    std::vector<std::pair<int, int>> expected(a.size() + b.size());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), by_key);
+
+    for (unsigned threads : {1u, 3u, 4u, 7u}) {
+        std::vector<std::pair<int, int>> out(a.size() + b.size());
+        auto end = quicksort::parallel::merge(a.begin(), a.end(), b.begin(), b.end(), out.begin(), by_key, threads);
+        EXPECT_TRUE(end == out.end());
+        EXPECT_EQ(out, expected);
+    }
+
+    std::vector<int> low(40000), high(40000), out(80000);
+    std::iota(low.begin(), low.end(), 0);
+    std::iota(high.begin(), high.end(), 40000);
+    quicksort::parallel::merge(high.begin(), high.end(), low.begin(), low.end(), out.begin(), std::less<>(), 4);
+    EXPECT_TRUE(std::is_sorted(out.begin(), out.end()));
+}
+
+TEST(QuicksortParallelTest, InplaceMerge) {
+    std::default_random_engine gen(52);
+    std::uniform_int_distribution<> distrib(0, 1000000);
+    std::deque<std::string> words(60000);
+    for (std::string& word : words) {
+        word = std::to_string(distrib(gen));
+    }
+    auto middle = words.begin() + 25000;
+    std::sort(words.begin(), middle);
+    std::sort(middle, words.end());
+    std::deque<std::string> expected = words;
+    std::inplace_merge(expected.begin(), expected.begin() + 25000, expected.end());
+
+    quicksort::parallel::inplace_merge(words.begin(), middle, words.end(), std::less<>(), 4);
+    EXPECT_EQ(words, expected);
+}
+
+TEST(QuicksortNumaTest, CpulistParsing) {
+    EXPECT_EQ(quicksort::numa::parse_cpulist("0-3,8-9,12\n"), (std::vector<unsigned>{0, 1, 2, 3, 8, 9, 12}));
+    EXPECT_EQ(quicksort::numa::parse_cpulist("5"), (std::vector<unsigned>{5}));
+    EXPECT_TRUE(quicksort::numa::parse_cpulist("").empty());
+    EXPECT_GE(quicksort::numa::detect_topology().nodes(), 1u);
+}
+
+TEST(QuicksortNumaTest, SimulatedTopology) {
+    quicksort::numa::simulate_topology(2, 3);
+    auto topology = quicksort::numa::current_topology();
+    ASSERT_EQ(topology.nodes(), 2u);
+    EXPECT_EQ(topology.node_cpus[1], (std::vector<unsigned>{3, 4, 5}));
+
+    std::default_random_engine gen(33);
+    std::uniform_int_distribution<> distrib(-1000000, 1000000);
+    std::vector<int> vec(200000);
+    for (int& i : vec) {
+        i = distrib(gen);
+    }
+    std::vector<int> expected = vec;
+    std::sort(expected.begin(), expected.end());
+
+    quicksort::parallel::sort(vec.begin(), vec.end(), std::less<>(), 5);
+    quicksort::numa::clear_simulated_topology();
+    EXPECT_EQ(vec, expected);
+}
+
+TEST(QuicksortResumableTest, ManualSlices) {
+    std::default_random_engine gen(44);
+    std::uniform_int_distribution<> distrib(-100000, 100000);
+    std::vector<int> vec(20000);
+    for (int& i : vec) {
+        i = distrib(gen);
+    }
+
+    auto task = quicksort::resumable_sort(vec.begin(), vec.end(), std::less<>(), {.comparisons = 1000});
+    int slices = 0;
+    while (task.resume()) {
+        ++slices;
+    }
+    EXPECT_TRUE(task.done());
+    EXPECT_GT(slices, 100);
+    EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+}
+
+TEST(QuicksortUniqueTest, MatchesSortThenUnique) {
+    std::default_random_engine gen(49);
+    for (int range : {0, 3, 100, 100000}) {
+        std::uniform_int_distribution<> distrib(0, range);
+        std::vector<int> vec(20000);
+        for (int& i : vec) {
+            i = distrib(gen);
+        }
+        std::vector<int> expected = vec;
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+        vec.erase(quicksort::sort_unique(vec.begin(), vec.end()), vec.end());
+        EXPECT_EQ(vec, expected);
+    }
+
+    std::deque<std::string> words = {"pear", "apple", "fig", "apple", "kiwi", "fig", "pear", "apple"};
+    auto end = quicksort::sort_unique(words.begin(), words.end(), std::greater<>());
+    EXPECT_EQ(std::deque<std::string>(words.begin(), end), (std::deque<std::string>{"pear", "kiwi", "fig", "apple"}));
+}
+
+TEST(QuicksortUniqueTest, CountsRuns) {
+    std::default_random_engine gen(50);
+    std::uniform_int_distribution<> distrib(0, 500);
+    std::vector<std::string> words(10000);
+    std::map<std::string, std::size_t> expected;
+    for (std::string& word : words) {
+        word = "w" + std::to_string(distrib(gen));
+        ++expected[word];
+    }
+
+    auto runs = quicksort::sort_count(words.begin(), words.end());
+    EXPECT_TRUE(std::is_sorted(words.begin(), words.end()));
+    EXPECT_EQ(runs, (std::vector<std::pair<std::string, std::size_t>>(expected.begin(), expected.end())));
+    EXPECT_TRUE(quicksort::sort_count(words.end(), words.end()).empty());
+}
+
+TEST(QuicksortFlatMultisetTest, BatchedInsertMatchesMultiset) {
+    std::default_random_engine gen(53);
+    std::uniform_int_distribution<> distrib(0, 2000);
+    quicksort::flat_multiset<int> flat;
+    std::multiset<int> expected;
+    for (std::size_t batch = 0; batch < 20; ++batch) {
+        std::vector<int> values(batch * 50);
+        for (int& v : values) {
+            v = distrib(gen);
+        }
+        flat.insert(values.begin(), values.end());
+        expected.insert(values.begin(), values.end());
+        int single = distrib(gen) + 5000;
+        flat.insert(single);
+        expected.insert(single);
+    }
+    EXPECT_TRUE(std::equal(flat.begin(), flat.end(), expected.begin(), expected.end()));
+
+    for (int key = -1; key <= 2001; ++key) {
+        EXPECT_EQ(flat.count(key), expected.count(key));
+        EXPECT_EQ(flat.lower_bound(key) - flat.begin(), std::distance(expected.begin(), expected.lower_bound(key)));
+        EXPECT_EQ(flat.upper_bound(key) - flat.begin(), std::distance(expected.begin(), expected.upper_bound(key)));
+        EXPECT_EQ(flat.contains(key), expected.count(key) > 0);
+    }
+}
+
+TEST(QuicksortFlatMultisetTest, UniqueInsertAndCustomComparator) {
+    quicksort::flat_multiset<std::string, std::greater<>> flat = {"kiwi", "apple"};
+    std::vector<std::string> batch = {"pear", "apple", "fig", "pear", "zucchini", "kiwi"};
+    flat.insert_unique(batch.begin(), batch.end());
+    EXPECT_EQ(std::vector<std::string>(flat.begin(), flat.end()),
+              (std::vector<std::string>{"zucchini", "pear", "kiwi", "fig", "apple"}));
+
+    flat.insert({"fig", "banana"});
+    EXPECT_EQ(flat.size(), 7u);
+    EXPECT_EQ(flat.count(std::string_view("fig")), 2u);
+    EXPECT_TRUE(flat.find("grape") == flat.end());
+
+    auto [first, last] = flat.equal_range("fig");
+    flat.erase(first, last);
+    EXPECT_EQ(std::vector<std::string>(flat.begin(), flat.end()),
+              (std::vector<std::string>{"zucchini", "pear", "kiwi", "banana", "apple"}));
+}
+
+TEST(QuicksortTopkTest, LargestOfStream) {
+    std::default_random_engine gen(54);
+    std::uniform_int_distribution<> distrib(-1000000, 1000000);
+    std::vector<int> stream(200000);
+    for (int& i : stream) {
+        i = distrib(gen);
+    }
+
+    quicksort::topk_accumulator<int> top(100);
+    for (int i : stream) {
+        top.push(i);
+    }
+    std::sort(stream.begin(), stream.end(), std::greater<>());
+    EXPECT_EQ(top.sorted(), std::vector<int>(stream.begin(), stream.begin() + 100));
+
+    quicksort::topk_accumulator<int> rising(10);
+    for (int i = 0; i < 50000; ++i) {
+        rising.push(i);
+    }
+    EXPECT_EQ(rising.sorted(), (std::vector<int>{49999, 49998, 49997, 49996, 49995, 49994, 49993, 49992, 49991, 49990}));
+}
+
+TEST(QuicksortTopkTest, SmallestStringsAndShortStreams) {
+    std::vector<std::string> words = {"pear", "fig", "apple", "kiwi", "banana", "cherry", "date", "apple"};
+    quicksort::topk_accumulator<std::string, std::less<>> first(3);
+    first.push(words.begin(), words.end());
+    EXPECT_EQ(first.sorted(), (std::vector<std::string>{"apple", "apple", "banana"}));
+
+    quicksort::topk_accumulator<std::string, std::less<>> all(20);
+    all.push(words.begin(), words.end());
+    std::sort(words.begin(), words.end());
+    EXPECT_EQ(all.sorted(), words);
+
+    quicksort::topk_accumulator<int> none(0);
+    none.push(42);
+    EXPECT_TRUE(none.sorted().empty());
+}
+
+struct move_tracked {
+    static inline std::size_t moves = 0;
+
+    int key = 0;
+    std::string payload;
+
+    move_tracked() = default;
+    move_tracked(int k) : key(k), payload(std::to_string(k)) {}
+    move_tracked(const move_tracked&) = default;
+    move_tracked(move_tracked&& other) noexcept : key(other.key), payload(std::move(other.payload)) { ++moves; }
+    move_tracked& operator=(const move_tracked&) = default;
+    move_tracked& operator=(move_tracked&& other) noexcept {
+        ++moves;
+        key = other.key;
+        payload = std::move(other.payload);
+        return *this;
+    }
+
+    bool operator<(const move_tracked& other) const { return key < other.key; }
+};
+
+TEST(QuicksortHolePartitionTest, FewerMovesForHeavyTypes) {
+    std::default_random_engine gen(48);
+    std::uniform_int_distribution<> distrib(-1000000, 1000000);
+    std::vector<move_tracked> items;
+    for (int i = 0; i < 4096; ++i) {
+        items.emplace_back(distrib(gen));
+    }
+
+    move_tracked::moves = 0;
+    quicksort::sort(items.begin(), items.end());
+    EXPECT_TRUE(std::is_sorted(items.begin(), items.end()));
+    for (const move_tracked& item : items) {
+        EXPECT_EQ(item.payload, std::to_string(item.key));
+    }
+    EXPECT_LT(move_tracked::moves, items.size() * 12);
+}
+
+struct detached_coroutine {
+    struct promise_type {
+        detached_coroutine get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct next_tick {
+    std::deque<std::coroutine_handle<>>& queue;
+
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> h) const { queue.push_back(h); }
+    void await_resume() const {}
+};
+
+detached_coroutine sort_on_event_loop(std::deque<std::string>& words, std::deque<std::coroutine_handle<>>& queue,
+                                      int& ticks, bool& finished) {
+    auto task = quicksort::resumable_sort(words.begin(), words.end(), std::greater<>(),
+                                          {.comparisons = 0, .time = std::chrono::microseconds(50)});
+    while (!co_await task) {
+        ++ticks;
+        co_await next_tick{queue};
+    }
+    finished = true;
+}
+
+TEST(QuicksortResumableTest, AwaitedFromEventLoop) {
+    std::default_random_engine gen(45);
+    std::uniform_int_distribution<> distrib(0, 1000000);
+    std::deque<std::string> words(30000);
+    for (std::string& word : words) {
+        word = std::to_string(distrib(gen));
+    }
+
+    std::deque<std::coroutine_handle<>> queue;
+    int ticks = 0;
+    bool finished = false;
+    sort_on_event_loop(words, queue, ticks, finished);
+    while (!queue.empty()) {
+        auto next = queue.front();
+        queue.pop_front();
+        next.resume();
+    }
+    EXPECT_TRUE(finished);
+    EXPECT_GT(ticks, 0);
+    EXPECT_TRUE(std::is_sorted(words.begin(), words.end(), std::greater<>()));
+}
+
+struct counting_resource : std::pmr::memory_resource {
+    std::size_t allocations = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+TEST(QuicksortScratchTest, ArenaIsReusedAcrossCalls) {
+    std::default_random_engine gen(46);
+    std::uniform_int_distribution<> distrib(-100000, 100000);
+    counting_resource upstream;
+    quicksort::scratch_arena arena(&upstream);
+
+    std::size_t after_first = 0;
+    for (int round = 0; round < 3; ++round) {
+        std::vector<int> vec(10000);
+        for (int& i : vec) {
+            i = distrib(gen);
+        }
+        quicksort::adaptive_sort(vec.begin(), vec.end(), std::less<>(), &arena);
+        EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+
+        std::vector<std::string> names(500);
+        for (std::string& name : names) {
+            name = "name" + std::to_string(distrib(gen));
+        }
+        quicksort::sort_by_prefix(names.begin(), names.end(), quicksort::string_prefix, std::less<>(), &arena);
+        EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+
+        if (round == 0) after_first = upstream.allocations;
+    }
+    EXPECT_GT(after_first, 0u);
+    EXPECT_LE(upstream.allocations, after_first + 1);
+    EXPECT_GE(arena.capacity(), 10000 / 2 * sizeof(int));
+}
+
+TEST(QuicksortScratchTest, ScopeRedirectsScratchAllocations) {
+    std::default_random_engine gen(47);
+    std::uniform_int_distribution<> distrib(-100000, 100000);
+    std::vector<int> keys(5000);
+    for (int& key : keys) {
+        key = distrib(gen);
+    }
+    std::vector<int> values(keys);
+    std::list<int> list(keys.begin(), keys.end());
+
+    counting_resource resource;
+    {
+        quicksort::scratch_scope scope(&resource);
+        quicksort::sort_by_key(keys.begin(), keys.end(), values.begin());
+        EXPECT_GT(resource.allocations, 0u);
+        quicksort::sort(list.begin(), list.end());
+    }
+    std::size_t inside = resource.allocations;
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_EQ(keys, values);
+    EXPECT_TRUE(std::is_sorted(list.begin(), list.end()));
+
+    quicksort::sort_table(values.rbegin(), values.rend(), keys.begin());
+    EXPECT_EQ(resource.allocations, inside);
+    EXPECT_TRUE(std::is_sorted(values.rbegin(), values.rend()));
+}
+
+#if defined(__unix__)
+TEST(QuicksortScratchTest, HugePageBackedArena) {
+    counting_resource small;
+    for (bool hugetlbfs : {false, true}) {
+        quicksort::huge_page_resource pages({.hugetlbfs = hugetlbfs, .prefault_threads = 4}, &small);
+        void* p = pages.allocate(std::size_t(5) << 20, 64);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % quicksort::huge_page_resource::page_size, 0u);
+        std::fill_n(static_cast<char*>(p), std::size_t(5) << 20, 'x');
+        pages.deallocate(p, std::size_t(5) << 20, 64);
+    }
+    EXPECT_EQ(small.allocations, 0u);
+
+    quicksort::huge_page_resource pages({}, &small);
+    quicksort::scratch_arena arena(&pages);
+    std::vector<int> vec(1 << 20);
+    for (std::size_t round = 0; round < 2; ++round) {
+        for (std::size_t i = 0; i < vec.size(); ++i) {
+            vec[i] = static_cast<int>((i * 7919) % 1000) + (i % 2 ? 0 : 1000);
+        }
+        quicksort::adaptive_sort(vec.begin(), vec.end(), std::less<>(), &arena);
+        EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+    }
+    EXPECT_GE(arena.capacity(), quicksort::huge_page_resource::page_size);
+    EXPECT_LE(small.allocations, 1u);
+}
+#endif
+
+#if defined(__unix__)
+template <class T, class Compare>
+void run_forked_sample_sort(const std::vector<T>& input, unsigned processes, Compare comp) {
+    std::string name = "/quicksort_test_" + std::to_string(getpid());
+    auto segment = quicksort::shm::sample_sort_segment<T>::create(name, input.size(), processes);
+    std::copy(input.begin(), input.end(), segment.data());
+
+    std::vector<pid_t> workers;
+    for (unsigned rank = 1; rank < processes; ++rank) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            try {
+                auto attached = quicksort::shm::sample_sort_segment<T>::open(name);
+                attached.sort(rank, comp);
+            } catch (...) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+    segment.sort(0, comp);
+
+    for (pid_t pid : workers) {
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    std::vector<T> expected = input;
+    std::sort(expected.begin(), expected.end(), comp);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), segment.data()));
+}
+
+TEST(QuicksortSharedMemoryTest, ForkedWorkers) {
+    std::default_random_engine gen(21);
+    std::uniform_int_distribution<> distrib(-50000, 50000);
+    std::vector<int> vec(100000);
+    for (int& i : vec) {
+        i = distrib(gen);
+    }
+    run_forked_sample_sort(vec, 4, std::less<>());
+}
+
+TEST(QuicksortSharedMemoryTest, FewerElementsThanProcesses) {
+    run_forked_sample_sort(std::vector<double>{3.5, 1.5, 2.5}, 4, std::greater<>());
+    run_forked_sample_sort(std::vector<double>(500, 1.0), 3, std::less<>());
+}
+#endif
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();